@@ -0,0 +1,442 @@
+#include <duckdb.hpp>
+#include <duckdb/function/aggregate_function.hpp>
+
+#include <string>
+
+#include "aggregate_functions.hpp"
+#include "assembly_stats.hpp"
+#include "fastq_qc.hpp"
+#include "kmer_bloom.hpp"
+
+using namespace duckdb;
+namespace fasql
+{
+
+    // Aggregate states only hold a pointer, the counters live on the heap until the destructor runs.
+    struct FastqQcState
+    {
+        FastqQcCounts *counts;
+    };
+
+    static idx_t FastqQcStateSize()
+    {
+        return sizeof(FastqQcState);
+    }
+
+    static void FastqQcInitialize(data_ptr_t state)
+    {
+        ((FastqQcState *)state)->counts = nullptr;
+    }
+
+    static void FastqQcAdd(FastqQcState &state, UnifiedVectorFormat &sequence_data, UnifiedVectorFormat &quality_data, idx_t i)
+    {
+        auto sequence_index = sequence_data.sel->get_index(i);
+        if (!sequence_data.validity.RowIsValid(sequence_index))
+        {
+            return;
+        }
+
+        if (!state.counts)
+        {
+            state.counts = new FastqQcCounts();
+        }
+
+        auto &sequence = ((string_t *)sequence_data.data)[sequence_index];
+        auto quality_index = quality_data.sel->get_index(i);
+
+        if (quality_data.validity.RowIsValid(quality_index))
+        {
+            auto &quality = ((string_t *)quality_data.data)[quality_index];
+            state.counts->Add(sequence.GetDataUnsafe(), sequence.GetSize(), quality.GetDataUnsafe(), quality.GetSize());
+        }
+        else
+        {
+            state.counts->Add(sequence.GetDataUnsafe(), sequence.GetSize(), nullptr, 0);
+        }
+    }
+
+    static void FastqQcUpdate(Vector inputs[], AggregateInputData &aggr_input_data, idx_t input_count, Vector &states, idx_t count)
+    {
+        UnifiedVectorFormat sequence_data, quality_data, state_data;
+        inputs[0].ToUnifiedFormat(count, sequence_data);
+        inputs[1].ToUnifiedFormat(count, quality_data);
+        states.ToUnifiedFormat(count, state_data);
+
+        auto state_pointers = (FastqQcState **)state_data.data;
+        for (idx_t i = 0; i < count; i++)
+        {
+            FastqQcAdd(*state_pointers[state_data.sel->get_index(i)], sequence_data, quality_data, i);
+        }
+    }
+
+    static void FastqQcSimpleUpdate(Vector inputs[], AggregateInputData &aggr_input_data, idx_t input_count, data_ptr_t state, idx_t count)
+    {
+        UnifiedVectorFormat sequence_data, quality_data;
+        inputs[0].ToUnifiedFormat(count, sequence_data);
+        inputs[1].ToUnifiedFormat(count, quality_data);
+
+        auto &qc_state = *(FastqQcState *)state;
+        for (idx_t i = 0; i < count; i++)
+        {
+            FastqQcAdd(qc_state, sequence_data, quality_data, i);
+        }
+    }
+
+    static void FastqQcCombine(Vector &source, Vector &target, AggregateInputData &aggr_input_data, idx_t count)
+    {
+        auto sources = FlatVector::GetData<FastqQcState *>(source);
+        auto targets = FlatVector::GetData<FastqQcState *>(target);
+
+        for (idx_t i = 0; i < count; i++)
+        {
+            if (!sources[i]->counts)
+            {
+                continue;
+            }
+
+            if (!targets[i]->counts)
+            {
+                targets[i]->counts = new FastqQcCounts();
+            }
+            targets[i]->counts->Merge(*sources[i]->counts);
+        }
+    }
+
+    static void FastqQcFinalize(Vector &states, AggregateInputData &aggr_input_data, Vector &result, idx_t count, idx_t offset)
+    {
+        UnifiedVectorFormat state_data;
+        states.ToUnifiedFormat(count, state_data);
+        auto state_pointers = (FastqQcState **)state_data.data;
+
+        if (states.GetVectorType() == VectorType::CONSTANT_VECTOR)
+        {
+            result.SetVectorType(VectorType::CONSTANT_VECTOR);
+        }
+
+        for (idx_t i = 0; i < count; i++)
+        {
+            auto &state = *state_pointers[state_data.sel->get_index(i)];
+            auto row = i + offset;
+
+            if (state.counts)
+            {
+                result.SetValue(row, state.counts->Finalize());
+            }
+            else
+            {
+                result.SetValue(row, Value(result.GetType()));
+            }
+        }
+    }
+
+    static void FastqQcDestroy(Vector &states, idx_t count)
+    {
+        auto state_pointers = FlatVector::GetData<FastqQcState *>(states);
+        for (idx_t i = 0; i < count; i++)
+        {
+            delete state_pointers[i]->counts;
+        }
+    }
+
+    unique_ptr<CreateAggregateFunctionInfo> AggregateFunctions::GetFastqQcFunction()
+    {
+        auto function = AggregateFunction("fastq_qc", {LogicalType::VARCHAR, LogicalType::VARCHAR}, FastqQcCounts::ResultType(),
+                                          FastqQcStateSize, FastqQcInitialize, FastqQcUpdate, FastqQcCombine, FastqQcFinalize,
+                                          FastqQcSimpleUpdate, nullptr, FastqQcDestroy);
+
+        CreateAggregateFunctionInfo fastq_qc_info(function);
+        return make_uniq<CreateAggregateFunctionInfo>(fastq_qc_info);
+    }
+
+    // The filter is sized from the first row's arguments, later rows must pass the same ones.
+    struct KmerBloomState
+    {
+        KmerBloomFilter *filter;
+        double fp_rate;
+        int64_t capacity;
+    };
+
+    static idx_t KmerBloomStateSize()
+    {
+        return sizeof(KmerBloomState);
+    }
+
+    static void KmerBloomInitialize(data_ptr_t state)
+    {
+        ((KmerBloomState *)state)->filter = nullptr;
+    }
+
+    static void KmerBloomAdd(KmerBloomState &state, UnifiedVectorFormat &sequence_data, UnifiedVectorFormat &k_data, UnifiedVectorFormat &fp_rate_data, UnifiedVectorFormat &capacity_data, idx_t i)
+    {
+        auto sequence_index = sequence_data.sel->get_index(i);
+        auto k_index = k_data.sel->get_index(i);
+        auto fp_rate_index = fp_rate_data.sel->get_index(i);
+        auto capacity_index = capacity_data.sel->get_index(i);
+
+        if (!sequence_data.validity.RowIsValid(sequence_index) || !k_data.validity.RowIsValid(k_index) || !fp_rate_data.validity.RowIsValid(fp_rate_index) ||
+            !capacity_data.validity.RowIsValid(capacity_index))
+        {
+            return;
+        }
+
+        auto k = ((int32_t *)k_data.data)[k_index];
+        auto fp_rate = ((double *)fp_rate_data.data)[fp_rate_index];
+        auto capacity = ((int64_t *)capacity_data.data)[capacity_index];
+
+        if (!state.filter)
+        {
+            if (k < 1 || k > (int32_t)KmerBloomFilter::MAX_K)
+            {
+                throw InvalidInputException("k must be between 1 and " + std::to_string(KmerBloomFilter::MAX_K) + ".");
+            }
+            if (!(fp_rate > 0 && fp_rate < 1))
+            {
+                throw InvalidInputException("fp_rate must be between 0 and 1.");
+            }
+            if (capacity < 1)
+            {
+                throw InvalidInputException("capacity must be at least 1.");
+            }
+
+            state.filter = new KmerBloomFilter(k, capacity, fp_rate);
+            state.fp_rate = fp_rate;
+            state.capacity = capacity;
+        }
+        else if (state.filter->K() != (idx_t)k || state.fp_rate != fp_rate || state.capacity != capacity)
+        {
+            throw InvalidInputException("kmer_bloom_build needs the same k, fp_rate and capacity for every row.");
+        }
+
+        auto &sequence = ((string_t *)sequence_data.data)[sequence_index];
+        state.filter->Insert(sequence.GetDataUnsafe(), sequence.GetSize());
+    }
+
+    static void KmerBloomUpdate(Vector inputs[], AggregateInputData &aggr_input_data, idx_t input_count, Vector &states, idx_t count)
+    {
+        UnifiedVectorFormat sequence_data, k_data, fp_rate_data, capacity_data, state_data;
+        inputs[0].ToUnifiedFormat(count, sequence_data);
+        inputs[1].ToUnifiedFormat(count, k_data);
+        inputs[2].ToUnifiedFormat(count, fp_rate_data);
+        inputs[3].ToUnifiedFormat(count, capacity_data);
+        states.ToUnifiedFormat(count, state_data);
+
+        auto state_pointers = (KmerBloomState **)state_data.data;
+        for (idx_t i = 0; i < count; i++)
+        {
+            KmerBloomAdd(*state_pointers[state_data.sel->get_index(i)], sequence_data, k_data, fp_rate_data, capacity_data, i);
+        }
+    }
+
+    static void KmerBloomSimpleUpdate(Vector inputs[], AggregateInputData &aggr_input_data, idx_t input_count, data_ptr_t state, idx_t count)
+    {
+        UnifiedVectorFormat sequence_data, k_data, fp_rate_data, capacity_data;
+        inputs[0].ToUnifiedFormat(count, sequence_data);
+        inputs[1].ToUnifiedFormat(count, k_data);
+        inputs[2].ToUnifiedFormat(count, fp_rate_data);
+        inputs[3].ToUnifiedFormat(count, capacity_data);
+
+        auto &bloom_state = *(KmerBloomState *)state;
+        for (idx_t i = 0; i < count; i++)
+        {
+            KmerBloomAdd(bloom_state, sequence_data, k_data, fp_rate_data, capacity_data, i);
+        }
+    }
+
+    static void KmerBloomCombine(Vector &source, Vector &target, AggregateInputData &aggr_input_data, idx_t count)
+    {
+        auto sources = FlatVector::GetData<KmerBloomState *>(source);
+        auto targets = FlatVector::GetData<KmerBloomState *>(target);
+
+        for (idx_t i = 0; i < count; i++)
+        {
+            if (!sources[i]->filter)
+            {
+                continue;
+            }
+
+            if (!targets[i]->filter)
+            {
+                // Nothing to merge into, the target takes over the source's filter.
+                *targets[i] = *sources[i];
+                sources[i]->filter = nullptr;
+                continue;
+            }
+            if (targets[i]->filter->K() != sources[i]->filter->K() || targets[i]->fp_rate != sources[i]->fp_rate || targets[i]->capacity != sources[i]->capacity)
+            {
+                throw InvalidInputException("kmer_bloom_build needs the same k, fp_rate and capacity for every row.");
+            }
+            targets[i]->filter->Merge(*sources[i]->filter);
+        }
+    }
+
+    static void KmerBloomFinalize(Vector &states, AggregateInputData &aggr_input_data, Vector &result, idx_t count, idx_t offset)
+    {
+        UnifiedVectorFormat state_data;
+        states.ToUnifiedFormat(count, state_data);
+        auto state_pointers = (KmerBloomState **)state_data.data;
+
+        if (states.GetVectorType() == VectorType::CONSTANT_VECTOR)
+        {
+            result.SetVectorType(VectorType::CONSTANT_VECTOR);
+        }
+
+        for (idx_t i = 0; i < count; i++)
+        {
+            auto &state = *state_pointers[state_data.sel->get_index(i)];
+            auto row = i + offset;
+
+            if (state.filter)
+            {
+                auto blob = state.filter->Serialize();
+                result.SetValue(row, Value::BLOB((const_data_ptr_t)blob.data(), blob.size()));
+            }
+            else
+            {
+                result.SetValue(row, Value(LogicalType::BLOB));
+            }
+        }
+    }
+
+    static void KmerBloomDestroy(Vector &states, idx_t count)
+    {
+        auto state_pointers = FlatVector::GetData<KmerBloomState *>(states);
+        for (idx_t i = 0; i < count; i++)
+        {
+            delete state_pointers[i]->filter;
+        }
+    }
+
+    unique_ptr<CreateAggregateFunctionInfo> AggregateFunctions::GetKmerBloomBuildFunction()
+    {
+        auto function = AggregateFunction("kmer_bloom_build", {LogicalType::VARCHAR, LogicalType::INTEGER, LogicalType::DOUBLE, LogicalType::BIGINT}, LogicalType::BLOB,
+                                          KmerBloomStateSize, KmerBloomInitialize, KmerBloomUpdate, KmerBloomCombine, KmerBloomFinalize,
+                                          KmerBloomSimpleUpdate, nullptr, KmerBloomDestroy);
+
+        CreateAggregateFunctionInfo kmer_bloom_build_info(function);
+        return make_uniq<CreateAggregateFunctionInfo>(kmer_bloom_build_info);
+    }
+
+    struct AssemblyStatsState
+    {
+        AssemblyStatsCounts *counts;
+    };
+
+    static idx_t AssemblyStatsStateSize()
+    {
+        return sizeof(AssemblyStatsState);
+    }
+
+    static void AssemblyStatsInitialize(data_ptr_t state)
+    {
+        ((AssemblyStatsState *)state)->counts = nullptr;
+    }
+
+    static void AssemblyStatsAdd(AssemblyStatsState &state, UnifiedVectorFormat &sequence_data, idx_t i)
+    {
+        auto sequence_index = sequence_data.sel->get_index(i);
+        if (!sequence_data.validity.RowIsValid(sequence_index))
+        {
+            return;
+        }
+
+        if (!state.counts)
+        {
+            state.counts = new AssemblyStatsCounts();
+        }
+
+        auto &sequence = ((string_t *)sequence_data.data)[sequence_index];
+        state.counts->Add(sequence.GetDataUnsafe(), sequence.GetSize());
+    }
+
+    static void AssemblyStatsUpdate(Vector inputs[], AggregateInputData &aggr_input_data, idx_t input_count, Vector &states, idx_t count)
+    {
+        UnifiedVectorFormat sequence_data, state_data;
+        inputs[0].ToUnifiedFormat(count, sequence_data);
+        states.ToUnifiedFormat(count, state_data);
+
+        auto state_pointers = (AssemblyStatsState **)state_data.data;
+        for (idx_t i = 0; i < count; i++)
+        {
+            AssemblyStatsAdd(*state_pointers[state_data.sel->get_index(i)], sequence_data, i);
+        }
+    }
+
+    static void AssemblyStatsSimpleUpdate(Vector inputs[], AggregateInputData &aggr_input_data, idx_t input_count, data_ptr_t state, idx_t count)
+    {
+        UnifiedVectorFormat sequence_data;
+        inputs[0].ToUnifiedFormat(count, sequence_data);
+
+        auto &stats_state = *(AssemblyStatsState *)state;
+        for (idx_t i = 0; i < count; i++)
+        {
+            AssemblyStatsAdd(stats_state, sequence_data, i);
+        }
+    }
+
+    static void AssemblyStatsCombine(Vector &source, Vector &target, AggregateInputData &aggr_input_data, idx_t count)
+    {
+        auto sources = FlatVector::GetData<AssemblyStatsState *>(source);
+        auto targets = FlatVector::GetData<AssemblyStatsState *>(target);
+
+        for (idx_t i = 0; i < count; i++)
+        {
+            if (!sources[i]->counts)
+            {
+                continue;
+            }
+
+            if (!targets[i]->counts)
+            {
+                targets[i]->counts = new AssemblyStatsCounts();
+            }
+            targets[i]->counts->Merge(*sources[i]->counts);
+        }
+    }
+
+    static void AssemblyStatsFinalize(Vector &states, AggregateInputData &aggr_input_data, Vector &result, idx_t count, idx_t offset)
+    {
+        UnifiedVectorFormat state_data;
+        states.ToUnifiedFormat(count, state_data);
+        auto state_pointers = (AssemblyStatsState **)state_data.data;
+
+        if (states.GetVectorType() == VectorType::CONSTANT_VECTOR)
+        {
+            result.SetVectorType(VectorType::CONSTANT_VECTOR);
+        }
+
+        for (idx_t i = 0; i < count; i++)
+        {
+            auto &state = *state_pointers[state_data.sel->get_index(i)];
+            auto row = i + offset;
+
+            if (state.counts)
+            {
+                result.SetValue(row, state.counts->Finalize());
+            }
+            else
+            {
+                result.SetValue(row, Value(result.GetType()));
+            }
+        }
+    }
+
+    static void AssemblyStatsDestroy(Vector &states, idx_t count)
+    {
+        auto state_pointers = FlatVector::GetData<AssemblyStatsState *>(states);
+        for (idx_t i = 0; i < count; i++)
+        {
+            delete state_pointers[i]->counts;
+        }
+    }
+
+    unique_ptr<CreateAggregateFunctionInfo> AggregateFunctions::GetAssemblyStatsFunction()
+    {
+        auto function = AggregateFunction("assembly_stats", {LogicalType::VARCHAR}, AssemblyStatsCounts::ResultType(),
+                                          AssemblyStatsStateSize, AssemblyStatsInitialize, AssemblyStatsUpdate, AssemblyStatsCombine, AssemblyStatsFinalize,
+                                          AssemblyStatsSimpleUpdate, nullptr, AssemblyStatsDestroy);
+
+        CreateAggregateFunctionInfo assembly_stats_info(function);
+        return make_uniq<CreateAggregateFunctionInfo>(assembly_stats_info);
+    }
+
+}
@@ -0,0 +1,139 @@
+#include <duckdb.hpp>
+
+#include <cstring>
+
+#include "assembly_stats.hpp"
+
+using namespace duckdb;
+namespace fasql
+{
+
+    // 1 for G and C, 2 for anything that isn't A, C, G or T.
+    struct AssemblyBaseClass
+    {
+        uint8_t index[256];
+
+        AssemblyBaseClass()
+        {
+            memset(index, 2, sizeof(index));
+            index['A'] = index['a'] = 0;
+            index['T'] = index['t'] = 0;
+            index['C'] = index['c'] = 1;
+            index['G'] = index['g'] = 1;
+        }
+    };
+
+    static const AssemblyBaseClass ASSEMBLY_BASE_CLASS;
+
+    LogicalType AssemblyStatsCounts::ResultType()
+    {
+        child_list_t<LogicalType> children;
+        children.push_back(make_pair("contigs", LogicalType::BIGINT));
+        children.push_back(make_pair("total_length", LogicalType::BIGINT));
+        children.push_back(make_pair("gc_content", LogicalType::DOUBLE));
+        children.push_back(make_pair("n_bases", LogicalType::BIGINT));
+        children.push_back(make_pair("min_length", LogicalType::BIGINT));
+        children.push_back(make_pair("max_length", LogicalType::BIGINT));
+        children.push_back(make_pair("mean_length", LogicalType::DOUBLE));
+        children.push_back(make_pair("lower_quartile", LogicalType::BIGINT));
+        children.push_back(make_pair("median_length", LogicalType::BIGINT));
+        children.push_back(make_pair("upper_quartile", LogicalType::BIGINT));
+        children.push_back(make_pair("n50", LogicalType::BIGINT));
+        children.push_back(make_pair("l50", LogicalType::BIGINT));
+        children.push_back(make_pair("n90", LogicalType::BIGINT));
+        children.push_back(make_pair("l90", LogicalType::BIGINT));
+        return LogicalType::STRUCT(std::move(children));
+    }
+
+    void AssemblyStatsCounts::Add(const char *sequence, idx_t length)
+    {
+        uint64_t counts[3] = {0, 0, 0};
+        for (idx_t i = 0; i < length; i++)
+        {
+            counts[ASSEMBLY_BASE_CLASS.index[(unsigned char)sequence[i]]]++;
+        }
+
+        contigs++;
+        total_length += length;
+        gc_bases += counts[1];
+        other_bases += counts[2];
+        lengths[length]++;
+    }
+
+    void AssemblyStatsCounts::Merge(const AssemblyStatsCounts &other)
+    {
+        contigs += other.contigs;
+        total_length += other.total_length;
+        gc_bases += other.gc_bases;
+        other_bases += other.other_bases;
+
+        for (auto &length : other.lengths)
+        {
+            lengths[length.first] += length.second;
+        }
+    }
+
+    // Length of the contig at rank floor(fraction * (contigs - 1)) when sorted shortest first, as quantile_disc picks it.
+    static uint64_t LengthQuantile(const std::map<uint64_t, uint64_t> &lengths, uint64_t contigs, double fraction)
+    {
+        auto rank = (uint64_t)(fraction * (contigs - 1));
+        uint64_t seen = 0;
+        for (auto &length : lengths)
+        {
+            seen += length.second;
+            if (seen > rank)
+            {
+                return length.first;
+            }
+        }
+
+        return lengths.rbegin()->first;
+    }
+
+    Value AssemblyStatsCounts::Finalize() const
+    {
+        // Nx is the length of the contig that takes the running total, longest first, to x% of the total length, Lx is
+        // how many contigs that took.
+        uint64_t n50 = 0, l50 = 0, n90 = 0, l90 = 0;
+        uint64_t covered = 0, counted = 0;
+        for (auto length = lengths.rbegin(); length != lengths.rend() && n90 == 0; length++)
+        {
+            for (uint64_t i = 0; i < length->second && n90 == 0; i++)
+            {
+                covered += length->first;
+                counted++;
+
+                if (n50 == 0 && covered * 2 >= total_length)
+                {
+                    n50 = length->first;
+                    l50 = counted;
+                }
+                if (covered * 10 >= total_length * 9)
+                {
+                    n90 = length->first;
+                    l90 = counted;
+                }
+            }
+        }
+
+        auto acgt_bases = total_length - other_bases;
+
+        child_list_t<Value> values;
+        values.push_back(make_pair("contigs", Value::BIGINT(contigs)));
+        values.push_back(make_pair("total_length", Value::BIGINT(total_length)));
+        values.push_back(make_pair("gc_content", acgt_bases == 0 ? Value(LogicalType::DOUBLE) : Value::DOUBLE((double)gc_bases / acgt_bases)));
+        values.push_back(make_pair("n_bases", Value::BIGINT(other_bases)));
+        values.push_back(make_pair("min_length", Value::BIGINT(lengths.begin()->first)));
+        values.push_back(make_pair("max_length", Value::BIGINT(lengths.rbegin()->first)));
+        values.push_back(make_pair("mean_length", Value::DOUBLE((double)total_length / contigs)));
+        values.push_back(make_pair("lower_quartile", Value::BIGINT(LengthQuantile(lengths, contigs, 0.25))));
+        values.push_back(make_pair("median_length", Value::BIGINT(LengthQuantile(lengths, contigs, 0.5))));
+        values.push_back(make_pair("upper_quartile", Value::BIGINT(LengthQuantile(lengths, contigs, 0.75))));
+        values.push_back(make_pair("n50", Value::BIGINT(n50)));
+        values.push_back(make_pair("l50", Value::BIGINT(l50)));
+        values.push_back(make_pair("n90", Value::BIGINT(n90)));
+        values.push_back(make_pair("l90", Value::BIGINT(l90)));
+        return Value::STRUCT(std::move(values));
+    }
+
+}
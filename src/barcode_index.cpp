@@ -0,0 +1,204 @@
+#include <duckdb.hpp>
+
+#include <bitset>
+#include <string>
+
+#include "barcode_index.hpp"
+
+using namespace duckdb;
+namespace fasql
+{
+
+    // Past this many neighbors in total the index costs more to build than scanning the packed barcodes.
+    static constexpr double MAX_NEIGHBORS = 1 << 20;
+    static constexpr uint64_t LOW_BITS = 0x5555555555555555ULL;
+
+    BarcodeIndex::BarcodeIndex(const std::vector<std::string> &barcodes, idx_t max_mismatches)
+        : barcodes(barcodes), max_mismatches(max_mismatches)
+    {
+        if (barcodes.empty())
+        {
+            return;
+        }
+
+        length = barcodes[0].size();
+        if (length == 0 || length > MAX_LENGTH)
+        {
+            throw InvalidInputException("Barcodes must be between 1 and " + std::to_string(MAX_LENGTH) + " bases long.");
+        }
+
+        for (auto &barcode : barcodes)
+        {
+            if (barcode.size() != length)
+            {
+                throw InvalidInputException("Barcodes must all be the same length.");
+            }
+
+            uint64_t key, unknown;
+            Pack(barcode.data(), length, key, unknown);
+            if (unknown)
+            {
+                throw InvalidInputException("Barcodes may only contain A, C, G and T: " + barcode);
+            }
+            packed.push_back(key);
+        }
+
+        // Sequences within d mismatches of a barcode number C(length, d) * 3^d.
+        double per_barcode = 0;
+        double term = 1;
+        for (idx_t d = 0; d <= max_mismatches && d <= length; d++)
+        {
+            per_barcode += term;
+            term = term * (length - d) / (d + 1) * 3;
+        }
+
+        indexed = per_barcode * barcodes.size() <= MAX_NEIGHBORS;
+        if (!indexed)
+        {
+            return;
+        }
+
+        neighbors.reserve(per_barcode * barcodes.size());
+        for (uint32_t i = 0; i < packed.size(); i++)
+        {
+            AddNeighbors(packed[i], i, 0, 0);
+        }
+    }
+
+    void BarcodeIndex::Pack(const char *sequence, idx_t length, uint64_t &packed, uint64_t &unknown)
+    {
+        packed = 0;
+        unknown = 0;
+
+        for (idx_t i = 0; i < length; i++)
+        {
+            uint64_t code;
+            switch (sequence[i])
+            {
+            case 'A':
+            case 'a':
+                code = 0;
+                break;
+            case 'C':
+            case 'c':
+                code = 1;
+                break;
+            case 'G':
+            case 'g':
+                code = 2;
+                break;
+            case 'T':
+            case 't':
+                code = 3;
+                break;
+            default:
+                code = 0;
+                unknown |= 1ULL << (2 * i);
+            }
+
+            packed |= code << (2 * i);
+        }
+    }
+
+    idx_t BarcodeIndex::Distance(uint64_t a, uint64_t b, uint64_t unknown)
+    {
+        // One bit per base that differs in either of its 2 bits, an unknown base always counts as a mismatch.
+        auto difference = a ^ b;
+        return std::bitset<64>(((difference | (difference >> 1)) & LOW_BITS) | unknown).count();
+    }
+
+    void BarcodeIndex::AddNeighbors(uint64_t key, uint32_t barcode, idx_t start, uint32_t distance)
+    {
+        auto entry = neighbors.find(key);
+        if (entry == neighbors.end() || distance < entry->second.distance)
+        {
+            neighbors[key] = Neighbor{barcode, distance};
+        }
+        else if (distance == entry->second.distance && entry->second.barcode != AMBIGUOUS && packed[entry->second.barcode] != packed[barcode])
+        {
+            entry->second.barcode = AMBIGUOUS;
+        }
+
+        if (distance == max_mismatches)
+        {
+            return;
+        }
+
+        for (auto i = start; i < length; i++)
+        {
+            auto base = (key >> (2 * i)) & 3;
+            for (uint64_t code = 0; code < 4; code++)
+            {
+                if (code != base)
+                {
+                    AddNeighbors((key & ~(3ULL << (2 * i))) | (code << (2 * i)), barcode, i + 1, distance + 1);
+                }
+            }
+        }
+    }
+
+    int64_t BarcodeIndex::Scan(uint64_t key, uint64_t unknown) const
+    {
+        auto best = NO_MATCH;
+        auto best_distance = max_mismatches + 1;
+        auto ambiguous = false;
+
+        for (idx_t i = 0; i < packed.size(); i++)
+        {
+            auto distance = Distance(key, packed[i], unknown);
+            if (distance < best_distance)
+            {
+                best = i;
+                best_distance = distance;
+                ambiguous = false;
+            }
+            else if (distance == best_distance && best != NO_MATCH && packed[best] != packed[i])
+            {
+                ambiguous = true;
+            }
+        }
+
+        return ambiguous ? NO_MATCH : best;
+    }
+
+    int64_t BarcodeIndex::Match(const char *sequence, idx_t size) const
+    {
+        if (packed.empty() || size < length)
+        {
+            return NO_MATCH;
+        }
+
+        uint64_t key, unknown;
+        Pack(sequence, length, key, unknown);
+
+        // Neighbors are only indexed for A, C, G and T, reads with an N are compared against every barcode.
+        if (!indexed || unknown)
+        {
+            return Scan(key, unknown);
+        }
+
+        auto entry = neighbors.find(key);
+        if (entry == neighbors.end() || entry->second.barcode == AMBIGUOUS)
+        {
+            return NO_MATCH;
+        }
+
+        return entry->second.barcode;
+    }
+
+    idx_t BarcodeIndex::Length() const
+    {
+        return length;
+    }
+
+    const std::vector<std::string> &BarcodeIndex::Barcodes() const
+    {
+        return barcodes;
+    }
+
+    idx_t BarcodeIndex::MaxMismatches() const
+    {
+        return max_mismatches;
+    }
+
+}
@@ -10,6 +10,8 @@
 #include "fasql_extension.hpp"
 #include "fasta_io.hpp"
 #include "fastq_io.hpp"
+#include "scalar_functions.hpp"
+#include "aggregate_functions.hpp"
 
 namespace duckdb
 {
@@ -28,6 +30,27 @@ namespace duckdb
         auto fastq_scan = fasql::FastqIO::GetFastqTableFunction();
         catalog.CreateTableFunction(context, fastq_scan.get());
 
+        auto fastx_fetch = fasql::ScalarFunctions::GetFastxFetchFunction();
+        catalog.CreateFunction(context, *fastx_fetch);
+
+        auto barcode_match = fasql::ScalarFunctions::GetBarcodeMatchFunction();
+        catalog.CreateFunction(context, *barcode_match);
+
+        auto seq_find_any = fasql::ScalarFunctions::GetSeqFindAnyFunction();
+        catalog.CreateFunction(context, *seq_find_any);
+
+        auto fastq_qc = fasql::AggregateFunctions::GetFastqQcFunction();
+        catalog.CreateFunction(context, *fastq_qc);
+
+        auto kmer_bloom_build = fasql::AggregateFunctions::GetKmerBloomBuildFunction();
+        catalog.CreateFunction(context, *kmer_bloom_build);
+
+        auto kmer_bloom_hits = fasql::ScalarFunctions::GetKmerBloomHitsFunction();
+        catalog.CreateFunction(context, *kmer_bloom_hits);
+
+        auto assembly_stats = fasql::AggregateFunctions::GetAssemblyStatsFunction();
+        catalog.CreateFunction(context, *assembly_stats);
+
         auto &config = DBConfig::GetConfig(context);
 
         auto fasta_replacement_scan = fasql::FastaIO::GetFastaReplacementScanFunction;
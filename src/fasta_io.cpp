@@ -3,56 +3,115 @@
 #include <duckdb/parser/expression/function_expression.hpp>
 
 #include <iostream>
+#include <mutex>
 #include <string>
 #include <vector>
 
-#if defined(__APPLE__) || defined(__linux__)
-#include <fcntl.h>
-#endif
-
 #include "fasta_io.hpp"
+#include "fastx_glob.hpp"
+#include "fastx_header.hpp"
+#include "fastx_reader.hpp"
+#include "motif_matcher.hpp"
+#include "fastx_writer.hpp"
 
-#include <kseq++/seqio.hpp>
-#include <kseq++/kseq++.hpp>
-
-using namespace klibpp;
 using namespace duckdb;
 
 namespace fasql
 {
 
+    // Column indexes of the scan, header_format columns follow the last one present.
+    enum FastaColumn : column_t
+    {
+        FASTA_ID = 0,
+        FASTA_DESCRIPTION,
+        FASTA_SEQUENCE,
+        FASTA_FILE_NAME,
+        FASTA_RECORD_OFFSET,
+    };
+
     struct FastaScanBindData : public TableFunctionData
     {
+        // Only the paths are known at bind, files are opened when a scan thread claims them.
         std::vector<std::string> file_paths;
-        int nth_file = 0;
 
-        klibpp::SeqStreamIn *stream;
+        FastxSampleOptions sample;
+        // Seeded at bind, every scan starts from a copy so reruns of a prepared statement sample the same records.
+        std::mt19937_64 rng;
+
+        FastxHeaderFormat header_format = FastxHeaderFormat::NONE;
+        idx_t header_column = 0;
+
+        // Scan column of each column of the COPY FROM target table, empty for read_fasta.
+        vector<column_t> copy_columns;
+
+        // Set when a seq_find_any filter on the sequence column was pushed into the scan.
+        unique_ptr<MotifMatcher> motif;
     };
 
     struct FastaScanLocalState : public LocalTableFunctionState
     {
+        unique_ptr<FastxReader> reader;
+        idx_t file_index = 0;
+        // Each claimed file samples with its own generator, seeded in file order, so threads don't share one.
+        std::mt19937_64 rng;
+
+        unique_ptr<FastxHeaderParser> header;
         bool done = false;
     };
 
     struct FastaScanGlobalState : public GlobalTableFunctionState
     {
         FastaScanGlobalState() : GlobalTableFunctionState() {}
+
+        idx_t MaxThreads() const override
+        {
+            return max_threads;
+        }
+
+        std::mutex lock;
+        idx_t next_file = 0;
+        idx_t max_threads = 1;
+        std::mt19937_64 rng;
+
+        // A fixed size sample is filled from every file by a single thread, then emitted from here.
+        unique_ptr<FastxReservoir> reservoir;
+        idx_t reservoir_position = 0;
+
+        // Columns the query reads in output order, headers are only split when one of their fields is read.
+        vector<column_t> column_ids;
+        bool header_needed = false;
     };
 
     unique_ptr<GlobalTableFunctionState> FastaInitGlobalState(ClientContext &context,
                                                               TableFunctionInitInput &input)
     {
+        auto &bind_data = (FastaScanBindData &)*input.bind_data;
         auto result = make_uniq<FastaScanGlobalState>();
+
+        result->rng = bind_data.rng;
+        result->max_threads = bind_data.sample.count > 0 ? 1 : bind_data.file_paths.size();
+
+        for (auto column : input.column_ids)
+        {
+            if (column != COLUMN_IDENTIFIER_ROW_ID && !bind_data.copy_columns.empty())
+            {
+                column = bind_data.copy_columns[column];
+            }
+
+            result->column_ids.push_back(column);
+            result->header_needed = result->header_needed || (column != COLUMN_IDENTIFIER_ROW_ID && column >= bind_data.header_column);
+        }
+
         return std::move(result);
     }
 
     unique_ptr<LocalTableFunctionState> FastaInitLocalState(ExecutionContext &context, TableFunctionInitInput &input,
                                                             GlobalTableFunctionState *global_state)
     {
-        // auto bind_data = (const FastaScanBindData *)input.bind_data;
-        // auto &gstate = (FastaScanGlobalState &)*global_state;
+        auto &bind_data = (FastaScanBindData &)*input.bind_data;
 
         auto local_state = make_uniq<FastaScanLocalState>();
+        local_state->header = make_uniq<FastxHeaderParser>(bind_data.header_format);
 
         return std::move(local_state);
     }
@@ -61,17 +120,8 @@ namespace fasql
                                        vector<LogicalType> &return_types, vector<string> &names)
     {
         auto result = make_uniq<FastaScanBindData>();
-        auto &fs = FileSystem::GetFileSystem(context);
-
-        auto glob = input.inputs[0].GetValue<std::string>();
-        std::vector<std::string> glob_result = fs.Glob(glob);
-        if (glob_result.size() == 0)
-        {
-            throw IOException("No files found for glob: " + glob);
-        }
-
-        result->file_paths = glob_result;
-        result->stream = new klibpp::SeqStreamIn(result->file_paths[0].c_str());
+        result->file_paths = FastxGlob::FromInput(context, input.inputs[0]);
+        result->sample = FastxSampleOptions::FromParameters(input.named_parameters, result->rng);
 
         return_types.push_back(LogicalType::VARCHAR);
         return_types.push_back(LogicalType::VARCHAR);
@@ -83,68 +133,176 @@ namespace fasql
         names.push_back("sequence");
         names.push_back("file_name");
 
+        auto record_offset = input.named_parameters.find("record_offset");
+        if (record_offset != input.named_parameters.end() && record_offset->second.GetValue<bool>())
+        {
+            return_types.push_back(LogicalType::BIGINT);
+            names.push_back("record_offset");
+        }
+
+        result->header_format = FastxHeaderParser::FromParameters(input.named_parameters);
+        result->header_column = names.size();
+        FastxHeaderParser::AddColumns(result->header_format, return_types, names);
+
         return std::move(result);
     }
 
-    void FastaScan(ClientContext &context, TableFunctionInput &data, DataChunk &output)
+    static void FastaSetRecord(DataChunk &output, const FastxRecord &record, const std::string &file_name, const FastaScanBindData &bind_data,
+                               FastaScanGlobalState &global_state, FastaScanLocalState &local_state)
     {
-        auto &bind_data = (FastaScanBindData &)*data.bind_data;
-        auto &local_state = (FastaScanLocalState &)*data.local_state;
+        auto row = output.size();
 
-        if (local_state.done)
+        if (global_state.header_needed)
         {
-            return;
+            local_state.header->Split(record);
+        }
+
+        for (idx_t i = 0; i < global_state.column_ids.size(); i++)
+        {
+            auto column = global_state.column_ids[i];
+            if (column == COLUMN_IDENTIFIER_ROW_ID)
+            {
+                continue;
+            }
+
+            if (column >= bind_data.header_column)
+            {
+                output.SetValue(i, row, local_state.header->Field(column - bind_data.header_column));
+                continue;
+            }
+
+            switch (column)
+            {
+            case FASTA_ID:
+                output.SetValue(i, row, Value(record.name));
+                break;
+            case FASTA_DESCRIPTION:
+                output.SetValue(i, row, record.comment.empty() ? Value() : Value(record.comment));
+                break;
+            case FASTA_SEQUENCE:
+                output.SetValue(i, row, Value(record.seq));
+                break;
+            case FASTA_FILE_NAME:
+                output.SetValue(i, row, Value(file_name));
+                break;
+            case FASTA_RECORD_OFFSET:
+                output.SetValue(i, row, Value::BIGINT(record.offset));
+                break;
+            }
         }
 
-        auto stream = bind_data.stream;
-        auto nth_file = bind_data.nth_file;
-        auto current_file = bind_data.file_paths[nth_file];
-        auto records = stream->read(STANDARD_VECTOR_SIZE);
+        output.SetCardinality(row + 1);
+    }
 
-        auto read_records = 0;
+    static void FastaPushdownComplexFilter(ClientContext &context, LogicalGet &get, FunctionData *bind_data_p, vector<unique_ptr<Expression>> &filters)
+    {
+        auto &bind_data = (FastaScanBindData &)*bind_data_p;
 
-        for (auto &record : records)
+        // Only one filter is taken over, any others stay with DuckDB. A fixed size sample is drawn from every record and
+        // then filtered, so the filter has to stay above the scan.
+        if (bind_data.motif || bind_data.sample.count > 0)
         {
-            output.SetValue(0, output.size(), Value(record.name));
+            return;
+        }
 
-            if (record.comment.empty())
+        bind_data.motif = MotifMatcher::FromFilters(context, get, filters);
+    }
+
+    // Hands the next unread file to this thread, returns false once every file has been claimed.
+    static bool FastaClaimFile(const FastaScanBindData &bind_data, FastaScanGlobalState &global_state, FastaScanLocalState &local_state)
+    {
+        {
+            std::lock_guard<std::mutex> guard(global_state.lock);
+            if (global_state.next_file >= bind_data.file_paths.size())
             {
-                output.SetValue(1, output.size(), Value());
+                return false;
             }
-            else
+
+            local_state.file_index = global_state.next_file++;
+            local_state.rng.seed(global_state.rng());
+        }
+
+        // Opened outside the lock, so threads don't wait on each other's files.
+        local_state.reader = make_uniq<FastxReader>(bind_data.file_paths[local_state.file_index], FastxFormat::FASTA, bind_data.sample, local_state.rng);
+        local_state.reader->SetMotif(bind_data.motif.get());
+        return true;
+    }
+
+    void FastaScan(ClientContext &context, TableFunctionInput &data, DataChunk &output)
+    {
+        auto &bind_data = (const FastaScanBindData &)*data.bind_data;
+        auto &local_state = (FastaScanLocalState &)*data.local_state;
+        auto &global_state = (FastaScanGlobalState &)*data.global_state;
+
+        if (local_state.done)
+        {
+            return;
+        }
+
+        // A fixed size sample needs to see every file before any record can be emitted, it's scanned on one thread.
+        if (bind_data.sample.count > 0)
+        {
+            if (!global_state.reservoir)
             {
-                output.SetValue(1, output.size(), Value(record.comment));
+                global_state.reservoir = make_uniq<FastxReservoir>(bind_data.sample.count, global_state.rng);
+                for (idx_t i = 0; i < bind_data.file_paths.size(); i++)
+                {
+                    FastxReader reader(bind_data.file_paths[i], FastxFormat::FASTA);
+                    reader.SetMotif(bind_data.motif.get());
+                    global_state.reservoir->Add(reader, i);
+                }
             }
 
-            output.SetValue(2, output.size(), Value(record.seq));
-            output.SetValue(3, output.size(), Value(current_file));
-
-            output.SetCardinality(output.size() + 1);
+            auto &reservoir = *global_state.reservoir;
+            while (output.size() < STANDARD_VECTOR_SIZE && global_state.reservoir_position < reservoir.records.size())
+            {
+                auto i = global_state.reservoir_position++;
+                FastaSetRecord(output, reservoir.records[i], bind_data.file_paths[reservoir.file_indexes[i]], bind_data, global_state, local_state);
+            }
 
-            read_records++;
+            local_state.done = global_state.reservoir_position == reservoir.records.size();
+            return;
         }
 
-        // We have read all records from the current file, check if we have more files or are done.
-        if (read_records < STANDARD_VECTOR_SIZE)
+        FastxRecord record;
+        while (output.size() < STANDARD_VECTOR_SIZE)
         {
-            if (bind_data.nth_file < bind_data.file_paths.size() - 1)
+            if (local_state.reader && local_state.reader->Next(record))
             {
-                bind_data.nth_file++;
-                bind_data.stream = new klibpp::SeqStreamIn(bind_data.file_paths[bind_data.nth_file].c_str());
+                FastaSetRecord(output, record, bind_data.file_paths[local_state.file_index], bind_data, global_state, local_state);
+                continue;
             }
-            else
+
+            // This thread's file is finished, move on to the next one nobody has claimed yet.
+            local_state.reader.reset();
+            if (!FastaClaimFile(bind_data, global_state, local_state))
             {
                 local_state.done = true;
+                break;
             }
         }
     };
 
+    static TableFunction FastaScanFunction(const LogicalType &files)
+    {
+        auto scan = TableFunction("read_fasta", {files}, FastaScan, FastaBind, FastaInitGlobalState, FastaInitLocalState);
+        scan.named_parameters["sample"] = LogicalType::DOUBLE;
+        scan.named_parameters["seed"] = LogicalType::BIGINT;
+        scan.named_parameters["record_offset"] = LogicalType::BOOLEAN;
+        scan.named_parameters["header_format"] = LogicalType::VARCHAR;
+        scan.projection_pushdown = true;
+        scan.pushdown_complex_filter = FastaPushdownComplexFilter;
+        return scan;
+    }
+
     unique_ptr<CreateTableFunctionInfo> FastaIO::GetFastaTableFunction()
     {
-        auto fasta_table_function = TableFunction("read_fasta", {LogicalType::VARCHAR}, FastaScan, FastaBind, FastaInitGlobalState, FastaInitLocalState);
+        // A glob, or a list of paths and globs.
+        TableFunctionSet set("read_fasta");
+        set.AddFunction(FastaScanFunction(LogicalType::VARCHAR));
+        set.AddFunction(FastaScanFunction(LogicalType::LIST(LogicalType::VARCHAR)));
 
-        CreateTableFunctionInfo fasta_table_function_info(fasta_table_function);
-        return make_uniq<CreateTableFunctionInfo>(fasta_table_function_info);
+        return make_uniq<CreateTableFunctionInfo>(std::move(set));
     }
 
     unique_ptr<TableRef> FastaIO::GetFastaReplacementScanFunction(ClientContext &context, const std::string &table_name, ReplacementScanData *data)
@@ -153,22 +311,21 @@ namespace fasql
 
         auto valid_fasta_filename = StringUtil::EndsWith(table_name, ".fa") || StringUtil::EndsWith(table_name, ".fasta");
         valid_fasta_filename = valid_fasta_filename || StringUtil::EndsWith(table_name, ".fa.gz") || StringUtil::EndsWith(table_name, ".fasta.gz");
+        valid_fasta_filename = valid_fasta_filename || StringUtil::EndsWith(table_name, ".fa.zst") || StringUtil::EndsWith(table_name, ".fasta.zst");
 
         if (!valid_fasta_filename)
         {
             return nullptr;
         };
 
-        auto &fs = FileSystem::GetFileSystem(context);
-
-        std::vector<std::string> glob_result = fs.Glob(table_name);
-        if (glob_result.size() == 0)
+        auto files = FastxGlob::ReplacementArgument(context, table_name);
+        if (files.IsNull())
         {
             return nullptr;
         }
 
         std::vector<unique_ptr<ParsedExpression>> children;
-        children.push_back(make_uniq<ConstantExpression>(Value(table_name)));
+        children.push_back(make_uniq<ConstantExpression>(std::move(files)));
 
         table_function->function = make_uniq<FunctionExpression>("read_fasta", std::move(children));
 
@@ -176,31 +333,26 @@ namespace fasql
     }
 
 #if defined(__APPLE__) || defined(__linux__)
-    struct FastaCopyScanOptions
-    {
-    };
-
     struct FastaWriteBindData : public TableFunctionData
     {
         std::string file_name;
+        FastxWriteOptions options;
+
+        idx_t id_index;
+        // DConstants::INVALID_INDEX when the records are written without descriptions.
+        idx_t description_index;
+        idx_t sequence_index;
     };
 
     struct FastaWriteGlobalState : public GlobalFunctionData
     {
-        int file_descriptor;
-        klibpp::KStream<int, ssize_t (*)(int __fd, const void *__buf, size_t __nbyte), klibpp::mode::Out_> stream;
-
-        // an example of an alternative constructor
-        FastaWriteGlobalState(int fd)
-            : file_descriptor(fd), stream(make_kstream(fd, write, klibpp::mode::out))
-        {
-        }
+        unique_ptr<FastxWriter> writer;
+        std::mutex lock;
     };
 
-    struct FastaCopyBindData : public TableFunctionData
+    struct FastaWriteLocalState : public LocalFunctionData
     {
-        std::string file_name;
-        klibpp::SeqStreamIn *in_stream;
+        FastxWriteBuffer buffer;
     };
 
     unique_ptr<FunctionData>
@@ -208,24 +360,31 @@ namespace fasql
     {
         auto result = make_uniq<FastaWriteBindData>();
         result->file_name = info.file_path;
+        result->options = FastxWriteOptions::FromCopyInfo(info, "FASTA");
 
+        // With rotation the first file written is the numbered one, the name given is never created.
         auto &fs = FileSystem::GetFileSystem(context);
-        auto copy_to_file_exists = fs.FileExists(result->file_name);
+        auto first_file = result->options.Rotating() ? FastxWriter::RotatedPath(result->file_name, 0) : result->file_name;
+        auto copy_to_file_exists = fs.FileExists(first_file);
 
         if (copy_to_file_exists)
         {
             throw std::runtime_error("File already exists, please remove.");
         }
 
-        if (!(names == std::vector<std::string>{"id", "description", "sequence"} || names == std::vector<std::string>{"id", "sequence"}))
+        // Columns are found by name, anything else in the query, such as PARTITION_BY columns, is not written.
+        result->id_index = FastxColumnIndex(names, "id");
+        result->description_index = FastxColumnIndex(names, "description");
+        result->sequence_index = FastxColumnIndex(names, "sequence");
+
+        if (result->id_index == DConstants::INVALID_INDEX || result->sequence_index == DConstants::INVALID_INDEX)
         {
             throw std::runtime_error("Invalid column names for FASTA file, expected 'id', 'description' and 'sequence' or 'id' and 'sequence'.");
         }
 
-        // check everything is varchars
-        for (auto &type : sql_types)
+        for (auto index : {result->id_index, result->description_index, result->sequence_index})
         {
-            if (type.id() != LogicalTypeId::VARCHAR)
+            if (index != DConstants::INVALID_INDEX && sql_types[index].id() != LogicalTypeId::VARCHAR)
             {
                 throw std::runtime_error("Invalid column type for FASTA file, expected VARCHAR.");
             }
@@ -237,20 +396,17 @@ namespace fasql
     static unique_ptr<GlobalFunctionData> FastaWriteInitializeGlobal(ClientContext &context, FunctionData &bind_data, const std::string &file_path)
     {
         auto &fasta_write_bind = (FastaWriteBindData &)bind_data;
-        auto file_name = fasta_write_bind.file_name;
-
-        auto compression = StringUtil::EndsWith(file_name, ".gz");
-
-        auto file_pointer = open(file_name.c_str(), O_WRONLY | O_CREAT, 0644);
 
-        auto global_state = make_uniq<FastaWriteGlobalState>(file_pointer);
+        // file_path is set per partition or per thread when the COPY writes more than one file, "-" writes to stdout.
+        auto global_state = make_uniq<FastaWriteGlobalState>();
+        global_state->writer = make_uniq<FastxWriter>(file_path, fasta_write_bind.options);
 
         return std::move(global_state);
     }
 
     static unique_ptr<LocalFunctionData> FastaWriteInitializeLocal(ExecutionContext &context, FunctionData &bind_data)
     {
-        auto local_data = make_uniq<LocalFunctionData>();
+        auto local_data = make_uniq<FastaWriteLocalState>();
         return std::move(local_data);
     }
 
@@ -259,76 +415,70 @@ namespace fasql
     {
         auto &bind_data = (FastaWriteBindData &)bind_data_p;
         auto &global_state = (FastaWriteGlobalState &)gstate;
+        auto &local_state = (FastaWriteLocalState &)lstate;
 
-        // First throw an error if the input size isn't two or three, then get a boolean for which is the case.
-        if (input.size() != 2 && input.size() != 3)
+        UnifiedVectorFormat ids, descriptions, sequences;
+        input.data[bind_data.id_index].ToUnifiedFormat(input.size(), ids);
+        input.data[bind_data.sequence_index].ToUnifiedFormat(input.size(), sequences);
+
+        auto has_description = bind_data.description_index != DConstants::INVALID_INDEX;
+        if (has_description)
         {
-            throw std::runtime_error("FastaWriteSink: input.size() != 2 && input.size() != 3");
+            input.data[bind_data.description_index].ToUnifiedFormat(input.size(), descriptions);
         }
 
-        auto two_columns = input.data.size() == 2;
-
-        if (two_columns)
+        for (idx_t i = 0; i < input.size(); i++)
         {
-            auto &id = input.data[0];
-            auto &sequence = input.data[1];
+            auto id_index = ids.sel->get_index(i);
+            auto sequence_index = sequences.sel->get_index(i);
 
-            for (size_t i = 0; i < input.size(); i++)
+            if (!ids.validity.RowIsValid(id_index) || !sequences.validity.RowIsValid(sequence_index))
             {
-                auto id_str = id.GetValue(i).ToString();
-                auto sequence_str = sequence.GetValue(i).ToString();
-
-                // Create the kseq record
-                // auto record = klibpp::KSeq(id_str, "", sequence_str, "");
-                auto record = klibpp::KSeq{
-                    id_str,
-                    "",
-                    sequence_str,
-                    "",
-                };
-
-                global_state.stream << record;
+                throw InvalidInputException("FASTA records can't have a NULL id or sequence.");
             }
-        }
-        else
-        {
-            auto &id = input.data[0];
-            auto &description = input.data[1];
-            auto &sequence = input.data[2];
 
-            for (size_t i = 0; i < input.size(); i++)
+            const string_t *description = nullptr;
+            if (has_description)
             {
-                auto id_str = id.GetValue(i).ToString();
-                auto description_str = description.GetValue(i).ToString();
-                auto sequence_str = sequence.GetValue(i).ToString();
-
-                auto record = klibpp::KSeq{
-                    id_str,
-                    description_str,
-                    sequence_str,
-                    "",
-                };
-
-                global_state.stream << record;
+                auto description_index = descriptions.sel->get_index(i);
+                if (descriptions.validity.RowIsValid(description_index))
+                {
+                    description = &((string_t *)descriptions.data)[description_index];
+                }
             }
+
+            local_state.buffer.AppendRecord('>', ((string_t *)ids.data)[id_index], description, ((string_t *)sequences.data)[sequence_index], nullptr);
+        }
+
+        // Records are formatted without the lock, only the write itself is serialized.
+        if (local_state.buffer.data.size() >= FastxWriteBuffer::FLUSH_SIZE)
+        {
+            std::lock_guard<std::mutex> guard(global_state.lock);
+            global_state.writer->Write(local_state.buffer);
+            local_state.buffer.Clear();
         }
     };
 
     static void FastaWriteCombine(ExecutionContext &context, FunctionData &bind_data, GlobalFunctionData &gstate, LocalFunctionData &lstate)
     {
+        auto &global_state = (FastaWriteGlobalState &)gstate;
+        auto &local_state = (FastaWriteLocalState &)lstate;
+
+        std::lock_guard<std::mutex> guard(global_state.lock);
+        global_state.writer->Write(local_state.buffer);
+        local_state.buffer.Clear();
     }
 
     void FastaWriteFinalize(ClientContext &context, FunctionData &bind_data, GlobalFunctionData &gstate)
     {
         auto &global_state = (FastaWriteGlobalState &)gstate;
 
-        global_state.stream << klibpp::kend;
-        close(global_state.file_descriptor);
+        global_state.writer->Close();
     };
 
     static unique_ptr<FunctionData> FastaCopyBind(ClientContext &context, CopyInfo &info, vector<std::string> &names, vector<LogicalType> &sql_types)
     {
-        auto result = make_uniq<FastaCopyBindData>();
+        auto result = make_uniq<FastaScanBindData>();
 
         // Check that the input names are correct
         if (names.size() == 3)
@@ -370,8 +520,18 @@ namespace fasql
             throw std::runtime_error("Invalid column types for FASTA COPY. Expected (VARCHAR, VARCHAR, VARCHAR) or (VARCHAR, VARCHAR)");
         }
 
-        result->file_name = info.file_path;
-        result->in_stream = new klibpp::SeqStreamIn(result->file_name.c_str());
+        // The copy is a read_fasta scan whose columns are mapped onto the target table's.
+        result->file_paths = FastxGlob::FromInput(context, Value(info.file_path));
+        result->header_column = FASTA_RECORD_OFFSET + 1;
+
+        if (names.size() == 3)
+        {
+            result->copy_columns = {FASTA_ID, FASTA_DESCRIPTION, FASTA_SEQUENCE};
+        }
+        else
+        {
+            result->copy_columns = {FASTA_ID, FASTA_SEQUENCE};
+        }
 
         return std::move(result);
     }
@@ -391,9 +551,7 @@ namespace fasql
 
         function.copy_from_bind = FastaCopyBind;
 
-        auto fasta_scan_function = TableFunction({LogicalType::VARCHAR}, FastaScan, FastaBind, FastaInitGlobalState, FastaInitLocalState);
-
-        function.copy_from_function = fasta_scan_function;
+        function.copy_from_function = FastaScanFunction(LogicalType::VARCHAR);
 
         function.extension = "fasta";
         return function;
@@ -2,50 +2,116 @@
 #include <duckdb/parser/expression/constant_expression.hpp>
 #include <duckdb/parser/expression/function_expression.hpp>
 
+#include <mutex>
 #include <string>
 
-#if defined(__APPLE__) || defined(__linux__)
-#include <fcntl.h>
-#endif
-
 #include "fastq_io.hpp"
-
-#include <kseq++/seqio.hpp>
-#include <kseq++/kseq++.hpp>
+#include "fastx_glob.hpp"
+#include "fastx_header.hpp"
+#include "fastx_reader.hpp"
+#include "motif_matcher.hpp"
+#include "fastx_writer.hpp"
 
 using namespace duckdb;
 namespace fasql
 {
 
+    // Column indexes of the scan, header_format columns follow the last one present.
+    enum FastqColumn : column_t
+    {
+        FASTQ_ID = 0,
+        FASTQ_DESCRIPTION,
+        FASTQ_SEQUENCE,
+        FASTQ_QUALITY_SCORES,
+        FASTQ_FILE_NAME,
+        FASTQ_RECORD_OFFSET,
+    };
+
     struct FastqScanBindData : public TableFunctionData
     {
+        // Only the paths are known at bind, files are opened when a scan thread claims them.
         std::vector<std::string> file_paths;
-        int nth_file = 0;
 
-        klibpp::SeqStreamIn *stream;
+        FastxSampleOptions sample;
+        // Seeded at bind, every scan starts from a copy so reruns of a prepared statement sample the same records.
+        std::mt19937_64 rng;
+
+        FastxTrimOptions trim;
+
+        FastxHeaderFormat header_format = FastxHeaderFormat::NONE;
+        idx_t header_column = 0;
+
+        // Scan column of each column of the COPY FROM target table, empty for read_fastq.
+        vector<column_t> copy_columns;
+
+        // Set when a seq_find_any filter on the sequence column was pushed into the scan.
+        unique_ptr<MotifMatcher> motif;
     };
 
     struct FastqScanLocalState : public LocalTableFunctionState
     {
+        unique_ptr<FastxReader> reader;
+        idx_t file_index = 0;
+        // Each claimed file samples with its own generator, seeded in file order, so threads don't share one.
+        std::mt19937_64 rng;
+
+        unique_ptr<FastxHeaderParser> header;
         bool done = false;
     };
 
     struct FastqScanGlobalState : public GlobalTableFunctionState
     {
         FastqScanGlobalState() : GlobalTableFunctionState() {}
+
+        idx_t MaxThreads() const override
+        {
+            return max_threads;
+        }
+
+        std::mutex lock;
+        idx_t next_file = 0;
+        idx_t max_threads = 1;
+        std::mt19937_64 rng;
+
+        // A fixed size sample is filled from every file by a single thread, then emitted from here.
+        unique_ptr<FastxReservoir> reservoir;
+        idx_t reservoir_position = 0;
+
+        // Columns the query reads in output order, headers are only split when one of their fields is read.
+        vector<column_t> column_ids;
+        bool header_needed = false;
     };
 
     unique_ptr<GlobalTableFunctionState> FastqInitGlobalState(ClientContext &context,
                                                               TableFunctionInitInput &input)
     {
+        auto &bind_data = (FastqScanBindData &)*input.bind_data;
         auto result = make_uniq<FastqScanGlobalState>();
+
+        result->rng = bind_data.rng;
+        result->max_threads = bind_data.sample.count > 0 ? 1 : bind_data.file_paths.size();
+
+        for (auto column : input.column_ids)
+        {
+            if (column != COLUMN_IDENTIFIER_ROW_ID && !bind_data.copy_columns.empty())
+            {
+                column = bind_data.copy_columns[column];
+            }
+
+            result->column_ids.push_back(column);
+            result->header_needed = result->header_needed || (column != COLUMN_IDENTIFIER_ROW_ID && column >= bind_data.header_column);
+        }
+
         return std::move(result);
     }
 
     unique_ptr<LocalTableFunctionState> FastqInitLocalState(ExecutionContext &context, TableFunctionInitInput &input,
                                                             GlobalTableFunctionState *global_state)
     {
+        auto &bind_data = (FastqScanBindData &)*input.bind_data;
+
         auto local_state = make_uniq<FastqScanLocalState>();
+        local_state->header = make_uniq<FastxHeaderParser>(bind_data.header_format);
 
         return std::move(local_state);
     }
@@ -54,16 +120,9 @@ namespace fasql
                                        vector<LogicalType> &return_types, vector<string> &names)
     {
         auto result = make_uniq<FastqScanBindData>();
-        auto &fs = FileSystem::GetFileSystem(context);
-
-        auto glob = input.inputs[0].GetValue<std::string>();
-        std::vector<std::string> glob_result = fs.Glob(glob);
-        if (glob_result.size() == 0)
-        {
-            throw IOException("No files found for glob: " + glob);
-        }
-        result->file_paths = glob_result;
-        result->stream = new klibpp::SeqStreamIn(result->file_paths[0].c_str());
+        result->file_paths = FastxGlob::FromInput(context, input.inputs[0]);
+        result->sample = FastxSampleOptions::FromParameters(input.named_parameters, result->rng);
+        result->trim = FastxTrimOptions::FromParameters(input.named_parameters);
 
         return_types.push_back(LogicalType::VARCHAR);
         return_types.push_back(LogicalType::VARCHAR);
@@ -77,77 +136,191 @@ namespace fasql
         names.push_back("quality_scores");
         names.push_back("file_name");
 
+        auto record_offset = input.named_parameters.find("record_offset");
+        if (record_offset != input.named_parameters.end() && record_offset->second.GetValue<bool>())
+        {
+            // fastx_fetch returns records as they are in the file, which wouldn't match the trimmed rows.
+            if (result->trim.Enabled())
+            {
+                throw InvalidInputException("record_offset can't be combined with trim_quality, trim_adapter or min_length.");
+            }
+
+            return_types.push_back(LogicalType::BIGINT);
+            names.push_back("record_offset");
+        }
+
+        result->header_format = FastxHeaderParser::FromParameters(input.named_parameters);
+        result->header_column = names.size();
+        FastxHeaderParser::AddColumns(result->header_format, return_types, names);
+
         return std::move(result);
     }
 
-    void FastqScan(ClientContext &context, TableFunctionInput &data, DataChunk &output)
+    static void FastqSetRecord(DataChunk &output, const FastxRecord &record, const std::string &file_name, const FastqScanBindData &bind_data,
+                               FastqScanGlobalState &global_state, FastqScanLocalState &local_state)
     {
-        auto &bind_data = (FastqScanBindData &)*data.bind_data;
-        auto &local_state = (FastqScanLocalState &)*data.local_state;
+        auto row = output.size();
 
-        if (local_state.done)
+        if (global_state.header_needed)
         {
-            return;
+            local_state.header->Split(record);
         }
 
-        auto stream = bind_data.stream;
-        auto nth_file = bind_data.nth_file;
-        auto current_file = bind_data.file_paths[nth_file];
-        auto records = stream->read(STANDARD_VECTOR_SIZE);
-
-        auto read_records = 0;
-
-        for (auto &record : records)
+        for (idx_t i = 0; i < global_state.column_ids.size(); i++)
         {
-            output.SetValue(0, output.size(), Value(record.name));
+            auto column = global_state.column_ids[i];
+            if (column == COLUMN_IDENTIFIER_ROW_ID)
+            {
+                continue;
+            }
 
-            if (record.comment.empty())
+            if (column >= bind_data.header_column)
             {
-                output.SetValue(1, output.size(), Value());
+                output.SetValue(i, row, local_state.header->Field(column - bind_data.header_column));
+                continue;
             }
-            else
+
+            switch (column)
             {
-                output.SetValue(1, output.size(), Value(record.comment));
+            case FASTQ_ID:
+                output.SetValue(i, row, Value(record.name));
+                break;
+            case FASTQ_DESCRIPTION:
+                output.SetValue(i, row, record.comment.empty() ? Value() : Value(record.comment));
+                break;
+            case FASTQ_SEQUENCE:
+                output.SetValue(i, row, Value(record.seq));
+                break;
+            case FASTQ_QUALITY_SCORES:
+                output.SetValue(i, row, record.qual.empty() ? Value() : Value(record.qual));
+                break;
+            case FASTQ_FILE_NAME:
+                output.SetValue(i, row, Value(file_name));
+                break;
+            case FASTQ_RECORD_OFFSET:
+                output.SetValue(i, row, Value::BIGINT(record.offset));
+                break;
             }
+        }
+
+        output.SetCardinality(row + 1);
+    }
+
+    static void FastqPushdownComplexFilter(ClientContext &context, LogicalGet &get, FunctionData *bind_data_p, vector<unique_ptr<Expression>> &filters)
+    {
+        auto &bind_data = (FastqScanBindData &)*bind_data_p;
 
-            output.SetValue(2, output.size(), Value(record.seq));
+        // Only one filter is taken over, any others stay with DuckDB. A fixed size sample is drawn from every record and
+        // then filtered, so the filter has to stay above the scan.
+        if (bind_data.motif || bind_data.sample.count > 0)
+        {
+            return;
+        }
 
-            if (record.qual.empty())
+        bind_data.motif = MotifMatcher::FromFilters(context, get, filters);
+    }
+
+    // Hands the next unread file to this thread, returns false once every file has been claimed.
+    static bool FastqClaimFile(const FastqScanBindData &bind_data, FastqScanGlobalState &global_state, FastqScanLocalState &local_state)
+    {
+        {
+            std::lock_guard<std::mutex> guard(global_state.lock);
+            if (global_state.next_file >= bind_data.file_paths.size())
             {
-                output.SetValue(3, output.size(), Value());
+                return false;
             }
-            else
+
+            local_state.file_index = global_state.next_file++;
+            local_state.rng.seed(global_state.rng());
+        }
+
+        // Opened outside the lock, so threads don't wait on each other's files.
+        local_state.reader = make_uniq<FastxReader>(bind_data.file_paths[local_state.file_index], FastxFormat::FASTQ, bind_data.sample, local_state.rng);
+        local_state.reader->SetMotif(bind_data.motif.get());
+        local_state.reader->SetTrim(bind_data.trim);
+        return true;
+    }
+
+    void FastqScan(ClientContext &context, TableFunctionInput &data, DataChunk &output)
+    {
+        auto &bind_data = (const FastqScanBindData &)*data.bind_data;
+        auto &local_state = (FastqScanLocalState &)*data.local_state;
+        auto &global_state = (FastqScanGlobalState &)*data.global_state;
+
+        if (local_state.done)
+        {
+            return;
+        }
+
+        // A fixed size sample needs to see every file before any record can be emitted, it's scanned on one thread.
+        if (bind_data.sample.count > 0)
+        {
+            if (!global_state.reservoir)
             {
-                output.SetValue(3, output.size(), Value(record.qual));
+                global_state.reservoir = make_uniq<FastxReservoir>(bind_data.sample.count, global_state.rng);
+                for (idx_t i = 0; i < bind_data.file_paths.size(); i++)
+                {
+                    FastxReader reader(bind_data.file_paths[i], FastxFormat::FASTQ);
+                    reader.SetMotif(bind_data.motif.get());
+                    reader.SetTrim(bind_data.trim);
+                    global_state.reservoir->Add(reader, i);
+                }
             }
 
-            output.SetValue(4, output.size(), Value(current_file));
-
-            output.SetCardinality(output.size() + 1);
+            auto &reservoir = *global_state.reservoir;
+            while (output.size() < STANDARD_VECTOR_SIZE && global_state.reservoir_position < reservoir.records.size())
+            {
+                auto i = global_state.reservoir_position++;
+                FastqSetRecord(output, reservoir.records[i], bind_data.file_paths[reservoir.file_indexes[i]], bind_data, global_state, local_state);
+            }
 
-            read_records++;
+            local_state.done = global_state.reservoir_position == reservoir.records.size();
+            return;
         }
 
-        if (read_records < STANDARD_VECTOR_SIZE)
+        FastxRecord record;
+        while (output.size() < STANDARD_VECTOR_SIZE)
         {
-            if (bind_data.nth_file < bind_data.file_paths.size() - 1)
+            if (local_state.reader && local_state.reader->Next(record))
             {
-                bind_data.nth_file++;
-                bind_data.stream = new klibpp::SeqStreamIn(bind_data.file_paths[bind_data.nth_file].c_str());
+                FastqSetRecord(output, record, bind_data.file_paths[local_state.file_index], bind_data, global_state, local_state);
+                continue;
             }
-            else
+
+            // This thread's file is finished, move on to the next one nobody has claimed yet.
+            local_state.reader.reset();
+            if (!FastqClaimFile(bind_data, global_state, local_state))
             {
                 local_state.done = true;
+                break;
             }
         }
     };
 
+    static TableFunction FastqScanFunction(const LogicalType &files)
+    {
+        auto scan = TableFunction("read_fastq", {files}, FastqScan, FastqBind, FastqInitGlobalState, FastqInitLocalState);
+        scan.named_parameters["sample"] = LogicalType::DOUBLE;
+        scan.named_parameters["seed"] = LogicalType::BIGINT;
+        scan.named_parameters["record_offset"] = LogicalType::BOOLEAN;
+        scan.named_parameters["trim_quality"] = LogicalType::INTEGER;
+        scan.named_parameters["trim_adapter"] = LogicalType::VARCHAR;
+        scan.named_parameters["adapter_error_rate"] = LogicalType::DOUBLE;
+        scan.named_parameters["min_length"] = LogicalType::BIGINT;
+        scan.named_parameters["header_format"] = LogicalType::VARCHAR;
+        scan.projection_pushdown = true;
+        scan.pushdown_complex_filter = FastqPushdownComplexFilter;
+        return scan;
+    }
+
     unique_ptr<CreateTableFunctionInfo> FastqIO::GetFastqTableFunction()
     {
-        auto scan = TableFunction("read_fastq", {LogicalType::VARCHAR}, FastqScan, FastqBind, FastqInitGlobalState, FastqInitLocalState);
+        // A glob, or a list of paths and globs.
+        TableFunctionSet set("read_fastq");
+        set.AddFunction(FastqScanFunction(LogicalType::VARCHAR));
+        set.AddFunction(FastqScanFunction(LogicalType::LIST(LogicalType::VARCHAR)));
 
-        CreateTableFunctionInfo fastq_table_function_info(scan);
-        return make_uniq<CreateTableFunctionInfo>(fastq_table_function_info);
+        return make_uniq<CreateTableFunctionInfo>(std::move(set));
     }
 
     unique_ptr<TableRef> FastqIO::GetFastqReplacementScanFunction(ClientContext &context, const std::string &table_name, ReplacementScanData *data)
@@ -156,53 +329,48 @@ namespace fasql
 
         auto valid_fasta_filename = StringUtil::EndsWith(table_name, ".fq") || StringUtil::EndsWith(table_name, ".fastq");
         valid_fasta_filename = valid_fasta_filename || StringUtil::EndsWith(table_name, ".fq.gz") || StringUtil::EndsWith(table_name, ".fastq.gz");
+        valid_fasta_filename = valid_fasta_filename || StringUtil::EndsWith(table_name, ".fq.zst") || StringUtil::EndsWith(table_name, ".fastq.zst");
 
         if (!valid_fasta_filename)
         {
             return nullptr;
         };
 
-        auto &fs = FileSystem::GetFileSystem(context);
-
-        std::vector<std::string> glob_result = fs.Glob(table_name);
-        if (glob_result.size() == 0)
+        auto files = FastxGlob::ReplacementArgument(context, table_name);
+        if (files.IsNull())
         {
             return nullptr;
         }
 
         std::vector<unique_ptr<ParsedExpression>> children;
-        children.push_back(make_uniq<ConstantExpression>(Value(table_name)));
+        children.push_back(make_uniq<ConstantExpression>(std::move(files)));
 
         table_function->function = make_uniq<FunctionExpression>("read_fastq", std::move(children));
 
         return table_function;
     }
 #if defined(__APPLE__) || defined(__linux__)
-    struct FastqCopyScanOptions
-    {
-    };
-
     struct FastqWriteBindData : public TableFunctionData
     {
         std::string file_name;
+        FastxWriteOptions options;
+
+        idx_t id_index;
+        // DConstants::INVALID_INDEX when the records are written without descriptions.
+        idx_t description_index;
+        idx_t sequence_index;
+        idx_t quality_scores_index;
     };
 
     struct FastqWriteGlobalState : public GlobalFunctionData
     {
-        int file_descriptor;
-        klibpp::KStream<int, ssize_t (*)(int __fd, const void *__buf, size_t __nbyte), klibpp::mode::Out_> stream;
-
-        // an example of an alternative constructor
-        FastqWriteGlobalState(int fd)
-            : file_descriptor(fd), stream(klibpp::make_kstream(fd, write, klibpp::mode::out))
-        {
-        }
+        unique_ptr<FastxWriter> writer;
+        std::mutex lock;
     };
 
-    struct FastqCopyBindData : public TableFunctionData
+    struct FastqWriteLocalState : public LocalFunctionData
     {
-        std::string file_name;
-        klibpp::SeqStreamIn *in_stream;
+        FastxWriteBuffer buffer;
     };
 
     unique_ptr<FunctionData>
@@ -210,25 +378,34 @@ namespace fasql
     {
         auto result = make_uniq<FastqWriteBindData>();
         result->file_name = info.file_path;
+        result->options = FastxWriteOptions::FromCopyInfo(info, "FASTQ");
 
+        // With rotation the first file written is the numbered one, the name given is never created.
         auto &fs = FileSystem::GetFileSystem(context);
-        auto copy_to_file_exists = fs.FileExists(result->file_name);
+        auto first_file = result->options.Rotating() ? FastxWriter::RotatedPath(result->file_name, 0) : result->file_name;
+        auto copy_to_file_exists = fs.FileExists(first_file);
 
         if (copy_to_file_exists)
         {
             throw std::runtime_error("File already exists, please remove.");
         }
 
-        if (!(names == std::vector<std::string>{"id", "description", "sequence", "quality_scores"} || names == std::vector<std::string>{"id", "sequence", "quality_scores"}))
+        // Columns are found by name, anything else in the query, such as PARTITION_BY columns, is not written.
+        result->id_index = FastxColumnIndex(names, "id");
+        result->description_index = FastxColumnIndex(names, "description");
+        result->sequence_index = FastxColumnIndex(names, "sequence");
+        result->quality_scores_index = FastxColumnIndex(names, "quality_scores");
+
+        if (result->id_index == DConstants::INVALID_INDEX || result->sequence_index == DConstants::INVALID_INDEX || result->quality_scores_index == DConstants::INVALID_INDEX)
         {
             throw std::runtime_error("Invalid column names for FASTQ file, expected id, description, sequence, quality_scores or id, sequence, quality_scores.");
         }
 
-        for (auto &type : sql_types)
+        for (auto index : {result->id_index, result->description_index, result->sequence_index, result->quality_scores_index})
         {
-            if (type.id() != LogicalTypeId::VARCHAR)
+            if (index != DConstants::INVALID_INDEX && sql_types[index].id() != LogicalTypeId::VARCHAR)
             {
-                throw std::runtime_error("Invalid column type for FASTA file, expected VARCHAR.");
+                throw std::runtime_error("Invalid column type for FASTQ file, expected VARCHAR.");
             }
         }
 
@@ -237,21 +414,18 @@ namespace fasql
 
     static unique_ptr<GlobalFunctionData> FastqWriteInitializeGlobal(ClientContext &context, FunctionData &bind_data, const std::string &file_path)
     {
-        auto &fasta_write_bind = (FastqWriteBindData &)bind_data;
-        auto file_name = fasta_write_bind.file_name;
-
-        auto compression = StringUtil::EndsWith(file_name, ".gz");
-
-        auto file_pointer = open(file_name.c_str(), O_WRONLY | O_CREAT, 0644);
+        auto &fastq_write_bind = (FastqWriteBindData &)bind_data;
 
-        auto global_state = make_uniq<FastqWriteGlobalState>(file_pointer);
+        // file_path is set per partition or per thread when the COPY writes more than one file, "-" writes to stdout.
+        auto global_state = make_uniq<FastqWriteGlobalState>();
+        global_state->writer = make_uniq<FastxWriter>(file_path, fastq_write_bind.options);
 
         return std::move(global_state);
     }
 
     static unique_ptr<LocalFunctionData> FastqWriteInitializeLocal(ExecutionContext &context, FunctionData &bind_data)
     {
-        auto local_data = make_uniq<LocalFunctionData>();
+        auto local_data = make_uniq<FastqWriteLocalState>();
         return std::move(local_data);
     }
 
@@ -260,93 +434,87 @@ namespace fasql
     {
         auto &bind_data = (FastqWriteBindData &)bind_data_p;
         auto &global_state = (FastqWriteGlobalState &)gstate;
+        auto &local_state = (FastqWriteLocalState &)lstate;
 
-        // First throw an error if the input size isn't two or three, then get a boolean for which is the case.
-        if (input.size() != 2 && input.size() != 3)
+        UnifiedVectorFormat ids, descriptions, sequences, quality_scores;
+        input.data[bind_data.id_index].ToUnifiedFormat(input.size(), ids);
+        input.data[bind_data.sequence_index].ToUnifiedFormat(input.size(), sequences);
+        input.data[bind_data.quality_scores_index].ToUnifiedFormat(input.size(), quality_scores);
+
+        auto has_description = bind_data.description_index != DConstants::INVALID_INDEX;
+        if (has_description)
         {
-            throw std::runtime_error("FastqWriteSink: input.size() != 3 && input.size() != 4");
+            input.data[bind_data.description_index].ToUnifiedFormat(input.size(), descriptions);
         }
 
-        auto three_columns = input.data.size() == 3;
-
-        if (three_columns)
+        for (idx_t i = 0; i < input.size(); i++)
         {
-            auto &id = input.data[0];
-            auto &sequence = input.data[1];
-            auto &quality_scores = input.data[2];
+            auto id_index = ids.sel->get_index(i);
+            auto sequence_index = sequences.sel->get_index(i);
+            auto quality_scores_index = quality_scores.sel->get_index(i);
 
-            for (size_t i = 0; i < input.size(); i++)
+            if (!ids.validity.RowIsValid(id_index) || !sequences.validity.RowIsValid(sequence_index) || !quality_scores.validity.RowIsValid(quality_scores_index))
             {
-                auto id_str = id.GetValue(i).ToString();
-                auto sequence_str = sequence.GetValue(i).ToString();
-                auto quality_scores_str = quality_scores.GetValue(i).ToString();
-
-                // Create the kseq record
-                auto record = klibpp::KSeq{
-                    id_str,
-                    "",
-                    sequence_str,
-                    quality_scores_str,
-                };
-
-                global_state.stream << record;
+                throw InvalidInputException("FASTQ records can't have a NULL id, sequence or quality_scores.");
             }
-        }
-        else
-        {
-            auto &id = input.data[0];
-            auto &description = input.data[1];
-            auto &sequence = input.data[2];
-            auto &quality_scores = input.data[3];
 
-            for (size_t i = 0; i < input.size(); i++)
+            const string_t *description = nullptr;
+            if (has_description)
             {
-                auto id_str = id.GetValue(i).ToString();
-                auto description_str = description.GetValue(i).ToString();
-                auto sequence_str = sequence.GetValue(i).ToString();
-                auto quality_scores_str = quality_scores.GetValue(i).ToString();
-
-                auto record = klibpp::KSeq{
-                    id_str,
-                    description_str,
-                    sequence_str,
-                    quality_scores_str,
-                };
-
-                global_state.stream << record;
+                auto description_index = descriptions.sel->get_index(i);
+                if (descriptions.validity.RowIsValid(description_index))
+                {
+                    description = &((string_t *)descriptions.data)[description_index];
+                }
             }
+
+            local_state.buffer.AppendRecord('@', ((string_t *)ids.data)[id_index], description, ((string_t *)sequences.data)[sequence_index],
+                                            &((string_t *)quality_scores.data)[quality_scores_index]);
+        }
+
+        // Records are formatted without the lock, only the write itself is serialized.
+        if (local_state.buffer.data.size() >= FastxWriteBuffer::FLUSH_SIZE)
+        {
+            std::lock_guard<std::mutex> guard(global_state.lock);
+            global_state.writer->Write(local_state.buffer);
+            local_state.buffer.Clear();
         }
     };
 
     static void FastqWriteCombine(ExecutionContext &context, FunctionData &bind_data, GlobalFunctionData &gstate, LocalFunctionData &lstate)
     {
+        auto &global_state = (FastqWriteGlobalState &)gstate;
+        auto &local_state = (FastqWriteLocalState &)lstate;
+
+        std::lock_guard<std::mutex> guard(global_state.lock);
+        global_state.writer->Write(local_state.buffer);
+        local_state.buffer.Clear();
     }
 
     void FastqWriteFinalize(ClientContext &context, FunctionData &bind_data, GlobalFunctionData &gstate)
     {
         auto &global_state = (FastqWriteGlobalState &)gstate;
 
-        global_state.stream << klibpp::kend;
-        close(global_state.file_descriptor);
+        global_state.writer->Close();
     };
 
     static unique_ptr<FunctionData> FastqCopyBind(ClientContext &context, CopyInfo &info, vector<std::string> &names, vector<LogicalType> &sql_types)
     {
-        auto result = make_uniq<FastqCopyBindData>();
+        auto result = make_uniq<FastqScanBindData>();
 
         // Check that the input names are correct
         if (names.size() == 4)
         {
             if (names[0] != "id" || names[1] != "description" || names[2] != "sequence" || names[3] != "quality_scores")
             {
-                throw std::runtime_error("Invalid column names for FASTA COPY. Expected (id, description, sequence)");
+                throw std::runtime_error("Invalid column names for FASTQ COPY. Expected (id, description, sequence, quality_scores)");
             }
         }
         else if (names.size() == 3)
         {
             if (names[0] != "id" || names[1] != "sequence" || names[2] != "quality_scores")
             {
-                throw std::runtime_error("Invalid column names for FASTA COPY. Expected (id, sequence)");
+                throw std::runtime_error("Invalid column names for FASTQ COPY. Expected (id, sequence, quality_scores)");
             }
         }
         else
@@ -354,19 +522,19 @@ namespace fasql
             throw std::runtime_error("Invalid column names for FASTQ COPY. Expected (id, description, sequence, quality_scores) or (id, sequence, quality_scores)");
         }
 
-        // Check the input types are correct, if 2 or 3 length is allowed and all must be varchars
-        if (sql_types.size() == 3)
+        // Check the input types are correct, if 3 or 4 length is allowed and all must be varchars
+        if (sql_types.size() == 4)
         {
             if (sql_types[0] != LogicalType::VARCHAR || sql_types[1] != LogicalType::VARCHAR || sql_types[2] != LogicalType::VARCHAR || sql_types[3] != LogicalType::VARCHAR)
             {
-                throw std::runtime_error("Invalid column types for FASTA COPY. Expected (VARCHAR, VARCHAR, VARCHAR, VARCHAR)");
+                throw std::runtime_error("Invalid column types for FASTQ COPY. Expected (VARCHAR, VARCHAR, VARCHAR, VARCHAR)");
             }
         }
         else if (sql_types.size() == 3)
         {
             if (sql_types[0] != LogicalType::VARCHAR || sql_types[1] != LogicalType::VARCHAR || sql_types[2] != LogicalType::VARCHAR)
             {
-                throw std::runtime_error("Invalid column types for FASTA COPY. Expected (VARCHAR, VARCHAR, VARCHAR)");
+                throw std::runtime_error("Invalid column types for FASTQ COPY. Expected (VARCHAR, VARCHAR, VARCHAR)");
             }
         }
         else
@@ -374,8 +542,18 @@ namespace fasql
             throw std::runtime_error("Invalid column types for FASTQ COPY. Expected (VARCHAR, VARCHAR, VARCHAR, VARCHAR) or (VARCHAR, VARCHAR, VARCHAR)");
         }
 
-        result->file_name = info.file_path;
-        result->in_stream = new klibpp::SeqStreamIn(result->file_name.c_str());
+        // The copy is a read_fastq scan whose columns are mapped onto the target table's.
+        result->file_paths = FastxGlob::FromInput(context, Value(info.file_path));
+        result->header_column = FASTQ_RECORD_OFFSET + 1;
+
+        if (names.size() == 4)
+        {
+            result->copy_columns = {FASTQ_ID, FASTQ_DESCRIPTION, FASTQ_SEQUENCE, FASTQ_QUALITY_SCORES};
+        }
+        else
+        {
+            result->copy_columns = {FASTQ_ID, FASTQ_SEQUENCE, FASTQ_QUALITY_SCORES};
+        }
 
         return std::move(result);
     }
@@ -395,9 +573,7 @@ namespace fasql
 
         function.copy_from_bind = FastqCopyBind;
 
-        auto fasta_scan_function = TableFunction("read_fastq", {LogicalType::VARCHAR}, FastqScan, FastqBind, FastqInitGlobalState, FastqInitLocalState);
-
-        function.copy_from_function = fasta_scan_function;
+        function.copy_from_function = FastqScanFunction(LogicalType::VARCHAR);
 
         function.extension = "fastq";
         return function;
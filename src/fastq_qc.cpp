@@ -0,0 +1,292 @@
+#include <duckdb.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#include "fastq_qc.hpp"
+
+using namespace duckdb;
+namespace fasql
+{
+
+    // Base index for each byte, 4 for anything that isn't A, C, G or T.
+    struct QcBaseIndex
+    {
+        uint8_t index[256];
+
+        QcBaseIndex()
+        {
+            memset(index, 4, sizeof(index));
+            index['A'] = index['a'] = 0;
+            index['C'] = index['c'] = 1;
+            index['G'] = index['g'] = 2;
+            index['T'] = index['t'] = 3;
+        }
+    };
+
+    static const QcBaseIndex QC_BASE_INDEX;
+
+    static LogicalType PositionType()
+    {
+        child_list_t<LogicalType> children;
+        children.push_back(make_pair("position", LogicalType::BIGINT));
+        children.push_back(make_pair("last_position", LogicalType::BIGINT));
+        children.push_back(make_pair("mean_quality", LogicalType::DOUBLE));
+        children.push_back(make_pair("median_quality", LogicalType::INTEGER));
+        children.push_back(make_pair("lower_quartile", LogicalType::INTEGER));
+        children.push_back(make_pair("upper_quartile", LogicalType::INTEGER));
+        children.push_back(make_pair("percentile_10", LogicalType::INTEGER));
+        children.push_back(make_pair("percentile_90", LogicalType::INTEGER));
+        children.push_back(make_pair("a", LogicalType::DOUBLE));
+        children.push_back(make_pair("c", LogicalType::DOUBLE));
+        children.push_back(make_pair("g", LogicalType::DOUBLE));
+        children.push_back(make_pair("t", LogicalType::DOUBLE));
+        children.push_back(make_pair("n", LogicalType::DOUBLE));
+        return LogicalType::STRUCT(std::move(children));
+    }
+
+    static LogicalType HistogramType(const std::string &key)
+    {
+        child_list_t<LogicalType> children;
+        children.push_back(make_pair(key, LogicalType::BIGINT));
+        children.push_back(make_pair("count", LogicalType::BIGINT));
+        return LogicalType::STRUCT(std::move(children));
+    }
+
+    LogicalType FastqQcCounts::ResultType()
+    {
+        child_list_t<LogicalType> children;
+        children.push_back(make_pair("reads", LogicalType::BIGINT));
+        children.push_back(make_pair("bases", LogicalType::BIGINT));
+        children.push_back(make_pair("gc_content", LogicalType::DOUBLE));
+        children.push_back(make_pair("mean_quality", LogicalType::DOUBLE));
+        children.push_back(make_pair("per_position", LogicalType::LIST(PositionType())));
+        children.push_back(make_pair("length_histogram", LogicalType::LIST(HistogramType("length"))));
+        children.push_back(make_pair("mean_quality_histogram", LogicalType::LIST(HistogramType("quality"))));
+        return LogicalType::STRUCT(std::move(children));
+    }
+
+    idx_t FastqQcCounts::BinOf(idx_t position)
+    {
+        if (position < EXACT_POSITIONS)
+        {
+            return position;
+        }
+
+        idx_t doublings = 0;
+        while ((position / EXACT_POSITIONS) >> (doublings + 1))
+        {
+            doublings++;
+        }
+        return EXACT_POSITIONS + doublings;
+    }
+
+    idx_t FastqQcCounts::BinEnd(idx_t bin)
+    {
+        if (bin < EXACT_POSITIONS)
+        {
+            return bin + 1;
+        }
+
+        auto doublings = bin - EXACT_POSITIONS + 1;
+        return doublings >= 54 ? NumericLimits<idx_t>::Maximum() : EXACT_POSITIONS << doublings;
+    }
+
+    void FastqQcCounts::Grow(idx_t count)
+    {
+        bins = count;
+        quality_counts.resize(bins * QUALITY_BINS);
+        base_counts.resize(bins * BASES);
+    }
+
+    void FastqQcCounts::Add(const char *sequence, idx_t length, const char *quality, idx_t quality_length)
+    {
+        reads++;
+        bases += length;
+        lengths[length]++;
+
+        if (length > 0 && BinOf(length - 1) >= bins)
+        {
+            Grow(BinOf(length - 1) + 1);
+        }
+
+        // Counters are laid out by bin, so each read walks both arrays front to back.
+        auto base_count = base_counts.data();
+        uint64_t gc = 0;
+        for (idx_t bin = 0, start = 0; start < length; bin++)
+        {
+            auto end = std::min(BinEnd(bin), length);
+            auto counts = base_count + bin * BASES;
+            for (idx_t i = start; i < end; i++)
+            {
+                auto base = QC_BASE_INDEX.index[(unsigned char)sequence[i]];
+                counts[base]++;
+                gc += base == 1 || base == 2;
+            }
+            start = end;
+        }
+        gc_bases += gc;
+
+        if (!quality)
+        {
+            return;
+        }
+
+        auto scored = std::min(length, quality_length);
+        auto quality_count = quality_counts.data();
+        uint64_t sum = 0;
+        for (idx_t bin = 0, start = 0; start < scored; bin++)
+        {
+            auto end = std::min(BinEnd(bin), scored);
+            auto counts = quality_count + bin * QUALITY_BINS;
+            for (idx_t i = start; i < end; i++)
+            {
+                auto score = std::min<idx_t>(std::max<int>((unsigned char)quality[i] - 33, 0), MAX_QUALITY);
+                counts[score]++;
+                sum += score;
+            }
+            start = end;
+        }
+
+        quality_bases += scored;
+        quality_sum += sum;
+        if (scored > 0)
+        {
+            mean_qualities[sum / scored]++;
+        }
+    }
+
+    void FastqQcCounts::Merge(const FastqQcCounts &other)
+    {
+        reads += other.reads;
+        bases += other.bases;
+        gc_bases += other.gc_bases;
+        quality_bases += other.quality_bases;
+        quality_sum += other.quality_sum;
+
+        if (other.bins > bins)
+        {
+            Grow(other.bins);
+        }
+        for (idx_t i = 0; i < other.quality_counts.size(); i++)
+        {
+            quality_counts[i] += other.quality_counts[i];
+        }
+        for (idx_t i = 0; i < other.base_counts.size(); i++)
+        {
+            base_counts[i] += other.base_counts[i];
+        }
+
+        for (auto &length : other.lengths)
+        {
+            lengths[length.first] += length.second;
+        }
+        for (idx_t i = 0; i < QUALITY_BINS; i++)
+        {
+            mean_qualities[i] += other.mean_qualities[i];
+        }
+    }
+
+    // Smallest score with at least fraction of the position's scores at or below it.
+    static Value Percentile(const uint64_t *counts, uint64_t total, double fraction)
+    {
+        if (total == 0)
+        {
+            return Value(LogicalType::INTEGER);
+        }
+
+        uint64_t seen = 0;
+        for (idx_t score = 0; score < FastqQcCounts::QUALITY_BINS; score++)
+        {
+            seen += counts[score];
+            if (seen >= fraction * total)
+            {
+                return Value::INTEGER(score);
+            }
+        }
+
+        return Value::INTEGER(FastqQcCounts::MAX_QUALITY);
+    }
+
+    static Value Ratio(uint64_t numerator, uint64_t denominator)
+    {
+        return denominator == 0 ? Value(LogicalType::DOUBLE) : Value::DOUBLE((double)numerator / denominator);
+    }
+
+    Value FastqQcCounts::Finalize() const
+    {
+        // The last bin ends at the longest read rather than at its full width.
+        idx_t longest = lengths.empty() ? 0 : lengths.rbegin()->first;
+        vector<Value> per_position;
+        for (idx_t bin = 0, start = 0; bin < bins; bin++)
+        {
+            auto end = std::min(BinEnd(bin), longest);
+            auto scores = quality_counts.data() + bin * QUALITY_BINS;
+            uint64_t scored = 0;
+            uint64_t score_sum = 0;
+            for (idx_t score = 0; score < QUALITY_BINS; score++)
+            {
+                scored += scores[score];
+                score_sum += scores[score] * score;
+            }
+
+            auto base_count = base_counts.data() + bin * BASES;
+            uint64_t covered = 0;
+            for (idx_t base = 0; base < BASES; base++)
+            {
+                covered += base_count[base];
+            }
+
+            child_list_t<Value> values;
+            values.push_back(make_pair("position", Value::BIGINT(start + 1)));
+            values.push_back(make_pair("last_position", Value::BIGINT(end)));
+            values.push_back(make_pair("mean_quality", Ratio(score_sum, scored)));
+            values.push_back(make_pair("median_quality", Percentile(scores, scored, 0.5)));
+            values.push_back(make_pair("lower_quartile", Percentile(scores, scored, 0.25)));
+            values.push_back(make_pair("upper_quartile", Percentile(scores, scored, 0.75)));
+            values.push_back(make_pair("percentile_10", Percentile(scores, scored, 0.1)));
+            values.push_back(make_pair("percentile_90", Percentile(scores, scored, 0.9)));
+            values.push_back(make_pair("a", Ratio(base_count[0], covered)));
+            values.push_back(make_pair("c", Ratio(base_count[1], covered)));
+            values.push_back(make_pair("g", Ratio(base_count[2], covered)));
+            values.push_back(make_pair("t", Ratio(base_count[3], covered)));
+            values.push_back(make_pair("n", Ratio(base_count[4], covered)));
+            per_position.push_back(Value::STRUCT(std::move(values)));
+            start = end;
+        }
+
+        vector<Value> length_histogram;
+        for (auto &length : lengths)
+        {
+            child_list_t<Value> values;
+            values.push_back(make_pair("length", Value::BIGINT(length.first)));
+            values.push_back(make_pair("count", Value::BIGINT(length.second)));
+            length_histogram.push_back(Value::STRUCT(std::move(values)));
+        }
+
+        vector<Value> mean_quality_histogram;
+        for (idx_t score = 0; score < QUALITY_BINS; score++)
+        {
+            if (mean_qualities[score] == 0)
+            {
+                continue;
+            }
+
+            child_list_t<Value> values;
+            values.push_back(make_pair("quality", Value::BIGINT(score)));
+            values.push_back(make_pair("count", Value::BIGINT(mean_qualities[score])));
+            mean_quality_histogram.push_back(Value::STRUCT(std::move(values)));
+        }
+
+        child_list_t<Value> values;
+        values.push_back(make_pair("reads", Value::BIGINT(reads)));
+        values.push_back(make_pair("bases", Value::BIGINT(bases)));
+        values.push_back(make_pair("gc_content", Ratio(gc_bases, bases)));
+        values.push_back(make_pair("mean_quality", Ratio(quality_sum, quality_bases)));
+        values.push_back(make_pair("per_position", Value::LIST(PositionType(), std::move(per_position))));
+        values.push_back(make_pair("length_histogram", Value::LIST(HistogramType("length"), std::move(length_histogram))));
+        values.push_back(make_pair("mean_quality_histogram", Value::LIST(HistogramType("quality"), std::move(mean_quality_histogram))));
+        return Value::STRUCT(std::move(values));
+    }
+
+}
@@ -0,0 +1,260 @@
+#include <duckdb.hpp>
+#include <duckdb/function/scalar/string_functions.hpp>
+#include <duckdb/parallel/task.hpp>
+#include <duckdb/parallel/task_scheduler.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fastx_glob.hpp"
+#include "fastx_source.hpp"
+
+using namespace duckdb;
+namespace fasql
+{
+
+    // Files matching pattern. A file with glob characters in its name is taken as it is when the glob matches nothing, so
+    // only those patterns pay for the extra lookup.
+    static std::vector<std::string> GlobOne(FileSystem &fs, const std::string &pattern)
+    {
+        auto files = fs.Glob(pattern);
+        if (files.empty() && FileSystem::HasGlob(pattern) && fs.FileExists(pattern))
+        {
+            files.push_back(pattern);
+        }
+        return files;
+    }
+
+    // Whether the file system's glob can't expand pattern by itself, it only matches files with the last part of a pattern.
+    static bool HasWildcardDirectory(const std::string &pattern)
+    {
+        auto separator = pattern.find_last_of("/\\");
+        return separator != std::string::npos && FileSystem::HasGlob(pattern.substr(0, separator));
+    }
+
+    // Patterns shared by the tasks of one GlobAll, each task takes the next pattern until there are none left.
+    struct GlobJob
+    {
+        GlobJob(FileSystem &fs, const std::vector<std::string> &patterns) : fs(fs), patterns(patterns), results(patterns.size())
+        {
+        }
+
+        void Run()
+        {
+            for (auto i = next++; i < patterns.size(); i = next++)
+            {
+                try
+                {
+                    results[i] = GlobOne(fs, patterns[i]);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    if (!error)
+                    {
+                        error = std::current_exception();
+                    }
+                    next = patterns.size();
+                }
+            }
+        }
+
+        FileSystem &fs;
+        const std::vector<std::string> &patterns;
+        std::vector<std::vector<std::string>> results;
+
+        std::atomic<idx_t> next{0};
+        std::atomic<idx_t> finished{0};
+        std::mutex lock;
+        std::exception_ptr error;
+    };
+
+    class GlobTask : public Task
+    {
+    public:
+        explicit GlobTask(shared_ptr<GlobJob> job) : job(std::move(job))
+        {
+        }
+
+        TaskExecutionResult Execute(TaskExecutionMode mode) override
+        {
+            job->Run();
+            job->finished++;
+            return TaskExecutionResult::TASK_FINISHED;
+        }
+
+    private:
+        shared_ptr<GlobJob> job;
+    };
+
+    // Globs every pattern on the scheduler's threads, so it's bounded by the threads setting. Results are in the same order
+    // as patterns.
+    static std::vector<std::vector<std::string>> GlobAll(ClientContext &context, const std::vector<std::string> &patterns)
+    {
+        auto &fs = FileSystem::GetFileSystem(context);
+        auto job = make_shared<GlobJob>(fs, patterns);
+
+        auto &scheduler = TaskScheduler::GetScheduler(context);
+        auto task_count = std::min<idx_t>(patterns.size(), scheduler.NumberOfThreads()) - (patterns.empty() ? 0 : 1);
+        auto producer = scheduler.CreateProducer();
+        for (idx_t i = 0; i < task_count; i++)
+        {
+            scheduler.ScheduleTask(*producer, make_shared<GlobTask>(job));
+        }
+
+        // This thread globs too and then runs whatever tasks no worker has picked up, so only tasks already running are
+        // waited for.
+        job->Run();
+        shared_ptr<Task> task;
+        while (scheduler.GetTaskFromProducer(*producer, task))
+        {
+            task->Execute(TaskExecutionMode::PROCESS_ALL);
+            task.reset();
+        }
+        while (job->finished < task_count)
+        {
+            std::this_thread::yield();
+        }
+
+        if (job->error)
+        {
+            std::rethrow_exception(job->error);
+        }
+        return std::move(job->results);
+    }
+
+    std::vector<std::string> FastxGlob::Expand(ClientContext &context, const std::string &pattern)
+    {
+        auto &fs = FileSystem::GetFileSystem(context);
+
+        // Pipes and stdin aren't regular files, globbing would not find them.
+        if (FastxSource::IsStream(pattern))
+        {
+            return {pattern};
+        }
+
+        if (!HasWildcardDirectory(pattern))
+        {
+            return GlobOne(fs, pattern);
+        }
+
+        // The directories matching the first part with wildcards in it are listed here, and a pattern like
+        // runs/*/reads_*.fastq.gz globs each run directory separately, rather than one after the other. Any wildcards after
+        // that are left to the glob of each directory.
+        auto wildcard = pattern.find_first_of("*?[");
+        auto parent_end = pattern.find_last_of("/\\", wildcard);
+        auto parent = parent_end == std::string::npos ? std::string() : pattern.substr(0, parent_end + 1);
+        auto directory_end = pattern.find_first_of("/\\", wildcard);
+        auto directory_glob = pattern.substr(parent.size(), directory_end - parent.size());
+
+        std::vector<std::string> patterns;
+        fs.ListFiles(parent.empty() ? "." : parent, [&](const std::string &name, bool is_directory)
+                     {
+            if (is_directory && LikeFun::Glob(name.c_str(), name.size(), directory_glob.c_str(), directory_glob.size()))
+            {
+                patterns.push_back(parent + name + pattern.substr(directory_end));
+            } });
+        std::sort(patterns.begin(), patterns.end());
+
+        std::vector<std::string> files;
+        for (auto &result : GlobAll(context, patterns))
+        {
+            files.insert(files.end(), result.begin(), result.end());
+        }
+
+        if (files.empty() && fs.FileExists(pattern))
+        {
+            files.push_back(pattern);
+        }
+        return files;
+    }
+
+    std::vector<std::string> FastxGlob::Expand(ClientContext &context, const std::vector<std::string> &patterns)
+    {
+        // Streams are read as they are and wildcard directories are expanded on their own, everything else is globbed at once.
+        std::vector<std::string> globs;
+        for (auto &pattern : patterns)
+        {
+            if (!FastxSource::IsStream(pattern) && !HasWildcardDirectory(pattern))
+            {
+                globs.push_back(pattern);
+            }
+        }
+
+        auto results = GlobAll(context, globs);
+
+        std::vector<std::string> files;
+        idx_t glob_index = 0;
+        for (auto &pattern : patterns)
+        {
+            if (FastxSource::IsStream(pattern) || HasWildcardDirectory(pattern))
+            {
+                auto expanded = Expand(context, pattern);
+                files.insert(files.end(), expanded.begin(), expanded.end());
+                continue;
+            }
+
+            auto &result = results[glob_index++];
+            if (result.empty() && !FileSystem::HasGlob(pattern))
+            {
+                throw IOException("No files found for: " + pattern);
+            }
+            files.insert(files.end(), result.begin(), result.end());
+        }
+        return files;
+    }
+
+    std::vector<std::string> FastxGlob::FromInput(ClientContext &context, const Value &input)
+    {
+        if (input.IsNull())
+        {
+            throw InvalidInputException("The files argument can't be NULL.");
+        }
+
+        if (input.type().id() != LogicalTypeId::LIST)
+        {
+            auto glob = input.GetValue<std::string>();
+            auto files = Expand(context, glob);
+            if (files.empty())
+            {
+                throw IOException("No files found for glob: " + glob);
+            }
+            return files;
+        }
+
+        std::vector<std::string> patterns;
+        for (auto &child : ListValue::GetChildren(input))
+        {
+            if (child.IsNull())
+            {
+                throw InvalidInputException("The files list can't contain NULL.");
+            }
+            patterns.push_back(child.GetValue<std::string>());
+        }
+
+        auto files = Expand(context, patterns);
+        if (files.empty())
+        {
+            throw IOException("No files found for: " + input.ToString());
+        }
+        return files;
+    }
+
+    Value FastxGlob::ReplacementArgument(ClientContext &context, const std::string &table_name)
+    {
+        auto &fs = FileSystem::GetFileSystem(context);
+
+        if (FastxSource::IsStream(table_name) || FileSystem::HasGlob(table_name))
+        {
+            return Value(table_name);
+        }
+
+        return fs.Glob(table_name).empty() ? Value() : Value(table_name);
+    }
+
+}
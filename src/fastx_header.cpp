@@ -0,0 +1,269 @@
+#include <duckdb.hpp>
+#include <duckdb/common/string_util.hpp>
+
+#include <cctype>
+#include <charconv>
+#include <string>
+
+#include "fastx_header.hpp"
+
+using namespace duckdb;
+namespace fasql
+{
+
+    struct FastxHeaderField
+    {
+        const char *name;
+        LogicalTypeId type;
+    };
+
+    // instrument:run_number:flowcell:lane:tile:x:y read_number:is_filtered:control_number:index_sequence
+    static const std::vector<FastxHeaderField> ILLUMINA_FIELDS = {
+        {"instrument", LogicalTypeId::VARCHAR},
+        {"run_number", LogicalTypeId::INTEGER},
+        {"flowcell", LogicalTypeId::VARCHAR},
+        {"lane", LogicalTypeId::INTEGER},
+        {"tile", LogicalTypeId::INTEGER},
+        {"x", LogicalTypeId::INTEGER},
+        {"y", LogicalTypeId::INTEGER},
+        {"read_number", LogicalTypeId::INTEGER},
+        {"is_filtered", LogicalTypeId::BOOLEAN},
+        {"control_number", LogicalTypeId::INTEGER},
+        {"index_sequence", LogicalTypeId::VARCHAR},
+    };
+
+    // db|accession|entry_name protein_name OS=organism OX=taxid GN=gene PE=protein_existence SV=sequence_version
+    static const std::vector<FastxHeaderField> UNIPROT_FIELDS = {
+        {"database", LogicalTypeId::VARCHAR},
+        {"accession", LogicalTypeId::VARCHAR},
+        {"entry_name", LogicalTypeId::VARCHAR},
+        {"protein_name", LogicalTypeId::VARCHAR},
+        {"organism", LogicalTypeId::VARCHAR},
+        {"taxid", LogicalTypeId::BIGINT},
+        {"gene", LogicalTypeId::VARCHAR},
+        {"protein_existence", LogicalTypeId::INTEGER},
+        {"sequence_version", LogicalTypeId::INTEGER},
+    };
+
+    // accession.version, optionally inside a gi|number|db|accession.version| id
+    static const std::vector<FastxHeaderField> NCBI_FIELDS = {
+        {"accession", LogicalTypeId::VARCHAR},
+        {"version", LogicalTypeId::INTEGER},
+    };
+
+    static const std::vector<FastxHeaderField> &HeaderFields(FastxHeaderFormat format)
+    {
+        static const std::vector<FastxHeaderField> none;
+
+        switch (format)
+        {
+        case FastxHeaderFormat::ILLUMINA:
+            return ILLUMINA_FIELDS;
+        case FastxHeaderFormat::UNIPROT:
+            return UNIPROT_FIELDS;
+        case FastxHeaderFormat::NCBI:
+            return NCBI_FIELDS;
+        default:
+            return none;
+        }
+    }
+
+    // Splits text on separator into at most count parts, returns count + 1 if there are more.
+    static idx_t SplitInto(std::string_view text, char separator, std::string_view *fields, idx_t count)
+    {
+        idx_t n = 0;
+        while (n < count)
+        {
+            auto end = text.find(separator);
+            fields[n++] = text.substr(0, end);
+            if (end == std::string_view::npos)
+            {
+                return n;
+            }
+            text.remove_prefix(end + 1);
+        }
+
+        // More parts than expected, the header isn't in this format.
+        return count + 1;
+    }
+
+    template <class T>
+    static Value ParseNumber(std::string_view text, LogicalType type)
+    {
+        T number;
+        auto result = std::from_chars(text.data(), text.data() + text.size(), number);
+        if (text.empty() || result.ec != std::errc() || result.ptr != text.data() + text.size())
+        {
+            return Value(type);
+        }
+
+        return Value::Numeric(type, number);
+    }
+
+    FastxHeaderParser::FastxHeaderParser(FastxHeaderFormat format) : format(format), fields(HeaderFields(format).size())
+    {
+    }
+
+    FastxHeaderFormat FastxHeaderParser::FromParameters(named_parameter_map_t &parameters)
+    {
+        auto header_format = parameters.find("header_format");
+        if (header_format == parameters.end())
+        {
+            return FastxHeaderFormat::NONE;
+        }
+
+        auto name = StringUtil::Lower(header_format->second.GetValue<std::string>());
+        if (name == "illumina")
+        {
+            return FastxHeaderFormat::ILLUMINA;
+        }
+        if (name == "uniprot")
+        {
+            return FastxHeaderFormat::UNIPROT;
+        }
+        if (name == "ncbi")
+        {
+            return FastxHeaderFormat::NCBI;
+        }
+
+        throw InvalidInputException("header_format must be one of 'illumina', 'uniprot' or 'ncbi'.");
+    }
+
+    void FastxHeaderParser::AddColumns(FastxHeaderFormat format, vector<LogicalType> &return_types, vector<string> &names)
+    {
+        for (auto &field : HeaderFields(format))
+        {
+            return_types.push_back(LogicalType(field.type));
+            names.push_back(field.name);
+        }
+    }
+
+    void FastxHeaderParser::Split(const FastxRecord &record)
+    {
+        for (auto &field : fields)
+        {
+            field = std::string_view();
+        }
+
+        switch (format)
+        {
+        case FastxHeaderFormat::ILLUMINA:
+            SplitIllumina(record);
+            break;
+        case FastxHeaderFormat::UNIPROT:
+            SplitUniprot(record);
+            break;
+        case FastxHeaderFormat::NCBI:
+            SplitNcbi(record);
+            break;
+        default:
+            break;
+        }
+    }
+
+    void FastxHeaderParser::SplitIllumina(const FastxRecord &record)
+    {
+        std::string_view parts[7];
+        if (SplitInto(record.name, ':', parts, 7) == 7)
+        {
+            std::copy(parts, parts + 7, fields.begin());
+        }
+
+        // Only the first word of the description, some pipelines append their own tags after it.
+        std::string_view comment(record.comment);
+        comment = comment.substr(0, comment.find_first_of(" \t"));
+        if (SplitInto(comment, ':', parts, 4) == 4)
+        {
+            std::copy(parts, parts + 4, fields.begin() + 7);
+        }
+    }
+
+    void FastxHeaderParser::SplitUniprot(const FastxRecord &record)
+    {
+        std::string_view parts[3];
+        if (SplitInto(record.name, '|', parts, 3) == 3)
+        {
+            std::copy(parts, parts + 3, fields.begin());
+        }
+
+        // Tags are a space, two capital letters and '=', each value runs to the next tag.
+        std::string_view comment(record.comment);
+        auto value_field = (idx_t)3;
+        idx_t value_start = 0;
+
+        for (idx_t i = 0; i <= comment.size(); i++)
+        {
+            auto tag = i + 3 < comment.size() && comment[i] == ' ' && isupper((unsigned char)comment[i + 1]) && isupper((unsigned char)comment[i + 2]) && comment[i + 3] == '=';
+            if (i < comment.size() && !tag)
+            {
+                continue;
+            }
+
+            if (value_field != DConstants::INVALID_INDEX)
+            {
+                fields[value_field] = comment.substr(value_start, i - value_start);
+            }
+
+            if (i == comment.size())
+            {
+                break;
+            }
+
+            auto name = comment.substr(i + 1, 2);
+            value_field = name == "OS" ? 4 : name == "OX" ? 5 : name == "GN" ? 6 : name == "PE" ? 7 : name == "SV" ? 8 : DConstants::INVALID_INDEX;
+            value_start = i + 4;
+            i += 3;
+        }
+    }
+
+    void FastxHeaderParser::SplitNcbi(const FastxRecord &record)
+    {
+        std::string_view id(record.name);
+
+        // gi|12345|ref|NC_000001.11| keeps the accession in the last field.
+        while (!id.empty() && id.back() == '|')
+        {
+            id.remove_suffix(1);
+        }
+        auto bar = id.rfind('|');
+        if (bar != std::string_view::npos)
+        {
+            id.remove_prefix(bar + 1);
+        }
+
+        auto dot = id.rfind('.');
+        fields[0] = id.substr(0, dot);
+        if (dot != std::string_view::npos)
+        {
+            fields[1] = id.substr(dot + 1);
+        }
+    }
+
+    Value FastxHeaderParser::Field(idx_t n) const
+    {
+        auto &text = fields[n];
+        auto type = HeaderFields(format)[n].type;
+
+        if (text.empty())
+        {
+            return Value(LogicalType(type));
+        }
+
+        switch (type)
+        {
+        case LogicalTypeId::INTEGER:
+            return ParseNumber<int32_t>(text, LogicalType::INTEGER);
+        case LogicalTypeId::BIGINT:
+            return ParseNumber<int64_t>(text, LogicalType::BIGINT);
+        case LogicalTypeId::BOOLEAN:
+            if (text == "Y" || text == "N")
+            {
+                return Value::BOOLEAN(text == "Y");
+            }
+            return Value(LogicalType::BOOLEAN);
+        default:
+            return Value(std::string(text));
+        }
+    }
+
+}
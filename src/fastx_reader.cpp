@@ -0,0 +1,622 @@
+#include <duckdb.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <string>
+
+#include "fastx_reader.hpp"
+#include "motif_matcher.hpp"
+
+using namespace duckdb;
+namespace fasql
+{
+
+    static constexpr size_t READER_BUFFER_SIZE = 1 << 16;
+    // Shortest adapter prefix trimmed from the end of a read, as cutadapt does.
+    static constexpr size_t ADAPTER_MIN_OVERLAP = 3;
+
+    // Returns a uniform double in (0, 1], safe to take the log of. Built from the top 53 bits directly rather than with
+    // std::uniform_real_distribution, whose output differs between standard libraries, so a seed samples the same records
+    // everywhere.
+    static double UniformOpen(std::mt19937_64 &rng)
+    {
+        return ((rng() >> 11) + 1) * 0x1.0p-53;
+    }
+
+    FastxSampleOptions FastxSampleOptions::FromParameters(named_parameter_map_t &parameters, std::mt19937_64 &rng)
+    {
+        FastxSampleOptions options;
+        rng.seed(std::random_device()());
+
+        for (auto &kv : parameters)
+        {
+            if (kv.first == "sample")
+            {
+                auto sample = kv.second.GetValue<double>();
+                if (sample <= 0)
+                {
+                    throw InvalidInputException("sample must be a fraction between 0 and 1 or a number of records.");
+                }
+
+                if (sample < 1)
+                {
+                    options.fraction = sample;
+                }
+                else if (sample == std::floor(sample))
+                {
+                    options.count = (idx_t)sample;
+                }
+                else
+                {
+                    throw InvalidInputException("sample must be a fraction between 0 and 1 or a whole number of records.");
+                }
+            }
+            else if (kv.first == "seed")
+            {
+                rng.seed(kv.second.GetValue<int64_t>());
+            }
+        }
+
+        return options;
+    }
+
+    FastxTrimOptions FastxTrimOptions::FromParameters(named_parameter_map_t &parameters)
+    {
+        FastxTrimOptions options;
+
+        for (auto &kv : parameters)
+        {
+            if (kv.first == "trim_quality")
+            {
+                options.quality = kv.second.GetValue<int32_t>();
+                if (options.quality < 0)
+                {
+                    throw InvalidInputException("trim_quality must not be negative.");
+                }
+            }
+            else if (kv.first == "trim_adapter")
+            {
+                options.adapter = kv.second.GetValue<std::string>();
+            }
+            else if (kv.first == "adapter_error_rate")
+            {
+                options.error_rate = kv.second.GetValue<double>();
+                if (!(options.error_rate >= 0 && options.error_rate < 1))
+                {
+                    throw InvalidInputException("adapter_error_rate must be at least 0 and below 1.");
+                }
+            }
+            else if (kv.first == "min_length")
+            {
+                auto min_length = kv.second.GetValue<int64_t>();
+                if (min_length < 0)
+                {
+                    throw InvalidInputException("min_length must not be negative.");
+                }
+                options.min_length = min_length;
+            }
+        }
+
+        return options;
+    }
+
+    bool FastxTrimOptions::Enabled() const
+    {
+        return quality > 0 || !adapter.empty() || min_length > 0;
+    }
+
+    bool FastxTrimOptions::Apply(FastxRecord &record) const
+    {
+        auto length = record.seq.size();
+
+        // BWA's algorithm, cut where the sum of (cutoff - score) over the 3' tail peaks.
+        if (quality > 0 && record.qual.size() == length)
+        {
+            auto scores = (const unsigned char *)record.qual.data();
+            int64_t sum = 0;
+            int64_t max = 0;
+            auto stop = length;
+
+            for (auto i = length; i > 0; i--)
+            {
+                sum += quality - (scores[i - 1] - 33);
+                if (sum < 0)
+                {
+                    break;
+                }
+                if (sum > max)
+                {
+                    max = sum;
+                    stop = i - 1;
+                }
+            }
+
+            length = stop;
+        }
+
+        if (!adapter.empty())
+        {
+            const char *seq = record.seq.data();
+            auto found = std::string::npos;
+
+            // As in cutadapt, the leftmost position where the adapter matches with at most error_rate mismatches per
+            // compared base, running off the end of the read with an overlap of at least ADAPTER_MIN_OVERLAP. Only
+            // substitutions are counted, not insertions or deletions.
+            for (size_t start = 0; start + ADAPTER_MIN_OVERLAP <= length; start++)
+            {
+                auto overlap = std::min(adapter.size(), length - start);
+                auto allowed = (size_t)(overlap * error_rate);
+
+                size_t mismatches = 0;
+                for (size_t i = 0; i < overlap && mismatches <= allowed; i++)
+                {
+                    mismatches += seq[start + i] != adapter[i];
+                }
+
+                if (mismatches <= allowed)
+                {
+                    found = start;
+                    break;
+                }
+            }
+
+            if (found != std::string::npos)
+            {
+                length = found;
+            }
+        }
+
+        if (length < min_length)
+        {
+            return false;
+        }
+
+        record.seq.resize(length);
+        if (!record.qual.empty())
+        {
+            record.qual.resize(std::min(length, record.qual.size()));
+        }
+
+        return true;
+    }
+
+    FastxReader::FastxReader(const std::string &path, FastxFormat format)
+        : path(path), source(FastxSource::Open(path)), format(format), buffer(READER_BUFFER_SIZE)
+    {
+        bgzf = dynamic_cast<BgzfSource *>(source.get());
+    }
+
+    FastxReader::FastxReader(const std::string &path) : FastxReader(path, FastxFormat::FASTQ)
+    {
+        if (FindHeader() && buffer[position] == '>')
+        {
+            format = FastxFormat::FASTA;
+        }
+    }
+
+    FastxReader::FastxReader(const std::string &path, FastxFormat format, const FastxSampleOptions &sample, std::mt19937_64 &rng)
+        : FastxReader(path, format)
+    {
+        fraction = sample.fraction;
+        this->rng = &rng;
+        // Picking blocks means seeking past the others, a pipe has to be read through and sampled record by record.
+        block_sampling = bgzf && bgzf->Seekable() && fraction < 1.0;
+    }
+
+    void FastxReader::SetTrim(const FastxTrimOptions &trim)
+    {
+        this->trim = trim;
+    }
+
+    void FastxReader::SetMotif(const MotifMatcher *motif)
+    {
+        this->motif = motif;
+    }
+
+    void FastxReader::Reset(uint64_t offset)
+    {
+        seek_block = DConstants::INVALID_INDEX;
+        buffer_offset = offset;
+        position = 0;
+        size = 0;
+        marked = false;
+    }
+
+    void FastxReader::Seek(uint64_t offset)
+    {
+        auto target = offset;
+        auto plain = dynamic_cast<PlainSource *>(source.get());
+
+        if (bgzf)
+        {
+            // Fetches in file order mostly land further on in the block already being inflated, which is read on from
+            // where it is. Going back, or to another block, starts inflating that block afresh.
+            target = offset & 0xffff;
+            if ((offset >> 16) != seek_block || target < buffer_offset + position)
+            {
+                bgzf->SeekBlock(offset >> 16);
+                Reset(0);
+                seek_block = offset >> 16;
+            }
+        }
+        else if (offset >= buffer_offset && offset <= buffer_offset + size)
+        {
+            // Already buffered, typically the next record after the last one fetched.
+        }
+        else if (plain)
+        {
+            plain->Seek(offset);
+            Reset(offset);
+        }
+        else if (offset < buffer_offset)
+        {
+            // gzip and zstd streams can't be repositioned, going backwards means decompressing from the start again.
+            source = FastxSource::Open(path);
+            Reset(0);
+        }
+
+        while (buffer_offset + position < target)
+        {
+            if (position == size && !Fill())
+            {
+                throw IOException("Record offset " + std::to_string(offset) + " is past the end of " + path);
+            }
+            position = std::min<uint64_t>(size, target - buffer_offset);
+        }
+
+        position = target - buffer_offset;
+    }
+
+    bool FastxReader::Fill()
+    {
+        // Compact the buffer, keeping the bytes from the mark onwards if a look ahead is in progress.
+        auto keep = marked ? mark : position;
+        if (keep > 0)
+        {
+            memmove(buffer.data(), buffer.data() + keep, size - keep);
+            buffer_offset += keep;
+            position -= keep;
+            size -= keep;
+            if (marked)
+            {
+                mark -= keep;
+            }
+        }
+
+        if (size == buffer.size())
+        {
+            buffer.resize(buffer.size() * 2);
+        }
+
+        auto read = source->Read(buffer.data() + size, buffer.size() - size);
+        size += read;
+
+        return read > 0;
+    }
+
+    int FastxReader::Peek()
+    {
+        if (position == size && !Fill())
+        {
+            return EOF;
+        }
+
+        return (unsigned char)buffer[position];
+    }
+
+    size_t FastxReader::ReadLine(std::string *line)
+    {
+        size_t length = 0;
+        char last = 0;
+
+        while (position < size || Fill())
+        {
+            auto start = buffer.data() + position;
+            auto newline = (char *)memchr(start, '\n', size - position);
+            auto n = newline ? (size_t)(newline - start) : size - position;
+
+            if (line)
+            {
+                line->append(start, n);
+            }
+            if (n > 0)
+            {
+                last = start[n - 1];
+            }
+
+            length += n;
+            position += n;
+
+            if (newline)
+            {
+                position++;
+                break;
+            }
+        }
+
+        if (last == '\r')
+        {
+            length--;
+            if (line)
+            {
+                line->pop_back();
+            }
+        }
+
+        return length;
+    }
+
+    bool FastxReader::FindHeader()
+    {
+        while (true)
+        {
+            auto c = Peek();
+            if (c == EOF)
+            {
+                return false;
+            }
+            if (c == '>' || c == '@')
+            {
+                return true;
+            }
+            ReadLine(nullptr);
+        }
+    }
+
+    void FastxReader::ParseRecord(FastxRecord *record)
+    {
+        // Also called for skipped records so the BGZF block list is trimmed as the reader moves on.
+        auto offset = buffer_offset + position;
+        offset = bgzf ? bgzf->VirtualOffset(offset) : offset;
+
+        // Skip the '>' or '@' marker, FindHeader has already peeked it into the buffer.
+        position++;
+
+        if (record)
+        {
+            record->offset = offset;
+
+            header.clear();
+            ReadLine(&header);
+
+            auto split = header.find_first_of(" \t");
+            if (split == std::string::npos)
+            {
+                record->name = header;
+                record->comment.clear();
+            }
+            else
+            {
+                record->name.assign(header, 0, split);
+                record->comment.assign(header, split + 1, std::string::npos);
+            }
+
+            record->seq.clear();
+            record->qual.clear();
+        }
+        else
+        {
+            ReadLine(nullptr);
+        }
+
+        size_t seq_length = 0;
+        int c;
+        while ((c = Peek()) != EOF && c != '>' && c != '+' && c != '@')
+        {
+            seq_length += ReadLine(record ? &record->seq : nullptr);
+        }
+
+        if (c != '+')
+        {
+            return;
+        }
+
+        ReadLine(nullptr);
+
+        size_t qual_length = 0;
+        while (qual_length < seq_length && Peek() != EOF)
+        {
+            qual_length += ReadLine(record ? &record->qual : nullptr);
+        }
+
+        if (qual_length != seq_length)
+        {
+            throw IOException("Quality scores are not the same length as the sequence.");
+        }
+    }
+
+    bool FastxReader::NextBlock()
+    {
+        while (bgzf->NextBlock())
+        {
+            if (UniformOpen(*rng) > fraction)
+            {
+                continue;
+            }
+
+            block_end = bgzf->OpenBlock();
+            Reset(0);
+
+            // Blocks are cut at arbitrary bytes, so Resync finds the first record that starts in this one.
+            if (Resync())
+            {
+                in_block = true;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool FastxReader::Resync()
+    {
+        // Only a header starts with '>', sequence lines never do.
+        if (format == FastxFormat::FASTA)
+        {
+            return FindHeader();
+        }
+
+        // '@' can also start a quality line, a header is only accepted if the line after its sequence starts with '+'.
+        while (FindHeader())
+        {
+            marked = true;
+            mark = position;
+
+            ReadLine(nullptr);
+            ReadLine(nullptr);
+            auto separator = Peek() == '+';
+
+            position = mark;
+            marked = false;
+
+            if (separator)
+            {
+                return true;
+            }
+
+            ReadLine(nullptr);
+        }
+
+        return false;
+    }
+
+    bool FastxReader::Next(FastxRecord &record)
+    {
+        if (!trim.Enabled() && !motif)
+        {
+            return NextRecord(record);
+        }
+
+        // Trimmed and filtered before the record is ever copied into a DuckDB vector.
+        while (NextRecord(record))
+        {
+            if (trim.Apply(record) && (!motif || motif->Matches(record.seq.data(), record.seq.size())))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool FastxReader::NextRecord(FastxRecord &record)
+    {
+        if (block_sampling)
+        {
+            while (true)
+            {
+                if (!in_block && !NextBlock())
+                {
+                    return false;
+                }
+
+                // Records belong to the block they start in, even when they run on into the next one.
+                if (FindHeader() && buffer_offset + position < block_end)
+                {
+                    ParseRecord(&record);
+                    return true;
+                }
+
+                in_block = false;
+            }
+        }
+
+        if (fraction < 1.0)
+        {
+            // The gap to the next sampled record is geometric, so the skipped records are never materialized.
+            auto gap = (idx_t)std::floor(std::log(UniformOpen(*rng)) / std::log1p(-fraction));
+            for (idx_t i = 0; i < gap; i++)
+            {
+                if (!SkipRecord())
+                {
+                    return false;
+                }
+            }
+        }
+
+        if (!FindHeader())
+        {
+            return false;
+        }
+
+        ParseRecord(&record);
+        return true;
+    }
+
+    bool FastxReader::Skip()
+    {
+        if (!trim.Enabled() && !motif)
+        {
+            return SkipRecord();
+        }
+
+        // Whether a record is dropped depends on its contents, so it has to be parsed to know which one to move past.
+        return Next(skipped);
+    }
+
+    bool FastxReader::SkipRecord()
+    {
+        if (!FindHeader())
+        {
+            return false;
+        }
+
+        ParseRecord(nullptr);
+        return true;
+    }
+
+    FastxReservoir::FastxReservoir(idx_t count, std::mt19937_64 &rng) : count(count), rng(rng)
+    {
+    }
+
+    void FastxReservoir::NextGap()
+    {
+        weight *= std::exp(std::log(UniformOpen(rng)) / count);
+        gap = (idx_t)std::floor(std::log(UniformOpen(rng)) / std::log1p(-weight));
+    }
+
+    void FastxReservoir::Add(FastxReader &reader, idx_t file_index)
+    {
+        while (records.size() < count)
+        {
+            FastxRecord record;
+            if (!reader.Next(record))
+            {
+                return;
+            }
+
+            records.push_back(std::move(record));
+            file_indexes.push_back(file_index);
+
+            if (records.size() == count)
+            {
+                weight = 1.0;
+                NextGap();
+            }
+        }
+
+        while (true)
+        {
+            for (; gap > 0; gap--)
+            {
+                if (!reader.Skip())
+                {
+                    return;
+                }
+            }
+
+            FastxRecord record;
+            if (!reader.Next(record))
+            {
+                return;
+            }
+
+            auto i = rng() % count;
+            records[i] = std::move(record);
+            file_indexes[i] = file_index;
+
+            NextGap();
+        }
+    }
+
+}
@@ -0,0 +1,380 @@
+#include <duckdb.hpp>
+#include <duckdb/common/string_util.hpp>
+
+#include <cstring>
+#include <string>
+
+#if defined(__APPLE__) || defined(__linux__)
+#include <sys/stat.h>
+#endif
+
+#include "fastx_source.hpp"
+
+#include "zstd.h"
+
+using namespace duckdb;
+namespace fasql
+{
+
+    // Large reads amortize the syscall and decompressor call overhead, zlib's gzread only uses 8 KiB by default.
+    static constexpr size_t INPUT_BUFFER_SIZE = 1 << 20;
+
+    FastxInput::FastxInput(const std::string &path) : buffer(INPUT_BUFFER_SIZE), path(path)
+    {
+        file = path == "-" ? stdin : fopen(path.c_str(), "rb");
+        if (file == nullptr)
+        {
+            throw IOException("Unable to open file: " + path);
+        }
+
+#ifdef _WIN32
+        seekable = _fseeki64(file, 0, SEEK_CUR) == 0;
+#else
+        seekable = fseeko(file, 0, SEEK_CUR) == 0;
+#endif
+    }
+
+    FastxInput::~FastxInput()
+    {
+        if (file != stdin)
+        {
+            fclose(file);
+        }
+    }
+
+    bool FastxInput::Fill()
+    {
+        if (position < size)
+        {
+            return true;
+        }
+
+        buffer_offset += size;
+        position = 0;
+        size = fread(buffer.data(), 1, buffer.size(), file);
+
+        if (size == 0 && ferror(file))
+        {
+            throw IOException("Unable to read file: " + path);
+        }
+
+        return size > 0;
+    }
+
+    void FastxInput::Seek(uint64_t offset)
+    {
+#ifdef _WIN32
+        auto status = _fseeki64(file, offset, SEEK_SET);
+#else
+        auto status = fseeko(file, offset, SEEK_SET);
+#endif
+        if (status != 0)
+        {
+            throw IOException("Unable to seek in file: " + path);
+        }
+
+        buffer_offset = offset;
+        position = 0;
+        size = 0;
+    }
+
+    bool FastxInput::ReadAt(uint64_t offset, unsigned char *data, size_t size)
+    {
+        Seek(offset);
+        return fread(data, 1, size, file) == size;
+    }
+
+    uint64_t FastxInput::Tell() const
+    {
+        return buffer_offset + position;
+    }
+
+    bool FastxInput::Seekable() const
+    {
+        return seekable;
+    }
+
+    FastxCompression FastxSource::DetectCompression(const unsigned char *magic, size_t size)
+    {
+        if (size >= 2 && magic[0] == 0x1f && magic[1] == 0x8b)
+        {
+            return FastxCompression::GZIP;
+        }
+
+        if (size >= 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd)
+        {
+            return FastxCompression::ZSTD;
+        }
+
+        return FastxCompression::NONE;
+    }
+
+    bool FastxSource::IsStream(const std::string &path)
+    {
+        if (path == "-" || path == "/dev/stdin" || StringUtil::StartsWith(path, "/dev/fd/") || StringUtil::StartsWith(path, "/proc/self/fd/"))
+        {
+            return true;
+        }
+
+#if defined(__APPLE__) || defined(__linux__)
+        struct stat status;
+        return stat(path.c_str(), &status) == 0 && (S_ISFIFO(status.st_mode) || S_ISCHR(status.st_mode));
+#else
+        return false;
+#endif
+    }
+
+    unique_ptr<FastxSource> FastxSource::Open(const std::string &path)
+    {
+        auto input = make_uniq<FastxInput>(path);
+        input->Fill();
+
+        switch (DetectCompression(input->buffer.data(), input->size))
+        {
+        case FastxCompression::GZIP:
+            if (BgzfSource::IsBgzf(input->buffer.data(), input->size))
+            {
+                return make_uniq<BgzfSource>(std::move(input));
+            }
+            return make_uniq<GzipSource>(std::move(input));
+        case FastxCompression::ZSTD:
+            return make_uniq<ZstdSource>(std::move(input));
+        default:
+            return make_uniq<PlainSource>(std::move(input));
+        }
+    }
+
+    PlainSource::PlainSource(unique_ptr<FastxInput> input) : input(std::move(input))
+    {
+    }
+
+    int PlainSource::Read(void *buffer, unsigned int size)
+    {
+        if (!input->Fill())
+        {
+            return 0;
+        }
+
+        auto n = std::min<size_t>(size, input->size - input->position);
+        memcpy(buffer, input->buffer.data() + input->position, n);
+        input->position += n;
+
+        return n;
+    }
+
+    void PlainSource::Seek(uint64_t offset)
+    {
+        input->Seek(offset);
+    }
+
+    // Checks the magic bytes that are available, a header split across two reads is left to inflate to check.
+    static bool IsGzipMagic(const unsigned char *data, size_t size)
+    {
+        return data[0] == 0x1f && (size < 2 || data[1] == 0x8b);
+    }
+
+    GzipSource::GzipSource(unique_ptr<FastxInput> input) : input(std::move(input))
+    {
+        memset(&stream, 0, sizeof(stream));
+
+        // 15 + 16 only accepts a gzip wrapper, the header is parsed by zlib.
+        if (inflateInit2(&stream, 15 + 16) != Z_OK)
+        {
+            throw IOException("Unable to initialize gzip decompression.");
+        }
+    }
+
+    GzipSource::~GzipSource()
+    {
+        inflateEnd(&stream);
+    }
+
+    int GzipSource::Read(void *buffer, unsigned int size)
+    {
+        stream.next_out = (Bytef *)buffer;
+        stream.avail_out = size;
+
+        while (stream.avail_out > 0 && !finished)
+        {
+            auto has_input = input->Fill();
+            auto available = stream.avail_out;
+
+            stream.next_in = input->buffer.data() + input->position;
+            stream.avail_in = input->size - input->position;
+
+            auto status = inflate(&stream, Z_NO_FLUSH);
+            input->position = input->size - stream.avail_in;
+            decompressed += available - stream.avail_out;
+
+            if (status == Z_STREAM_END)
+            {
+                // BGZF and concatenated files are a series of gzip members, continue with the next one if present. Like
+                // gzread, anything after the last member that isn't a gzip header, such as zero padding, is ignored.
+                if (!input->Fill() || !IsGzipMagic(input->buffer.data() + input->position, input->size - input->position))
+                {
+                    finished = true;
+                    break;
+                }
+
+                inflateReset(&stream);
+                StartMember();
+            }
+            else if (status != Z_OK && status != Z_BUF_ERROR)
+            {
+                throw IOException("Invalid gzip data: " + std::string(stream.msg ? stream.msg : "unknown error"));
+            }
+            else if (!has_input && stream.avail_out == available)
+            {
+                throw IOException("Unexpected end of gzip data.");
+            }
+        }
+
+        return size - stream.avail_out;
+    }
+
+    // The fixed gzip header of a BGZF block with its BC extra subfield, see the SAM specification.
+    static constexpr size_t BGZF_HEADER_SIZE = 18;
+
+    BgzfSource::BgzfSource(unique_ptr<FastxInput> input) : GzipSource(std::move(input))
+    {
+        blocks.push_back({0, 0});
+    }
+
+    bool BgzfSource::IsBgzf(const unsigned char *header, size_t size)
+    {
+        return size >= BGZF_HEADER_SIZE && header[0] == 0x1f && header[1] == 0x8b && header[2] == 8 && (header[3] & 4) &&
+               header[10] == 6 && header[11] == 0 && header[12] == 'B' && header[13] == 'C' && header[14] == 2 && header[15] == 0;
+    }
+
+    bool BgzfSource::NextBlock()
+    {
+        auto offset = started ? block_offset + block_size : 0;
+        started = true;
+
+        unsigned char header[BGZF_HEADER_SIZE];
+        if (!input->ReadAt(offset, header, BGZF_HEADER_SIZE))
+        {
+            return false;
+        }
+
+        if (!IsBgzf(header, BGZF_HEADER_SIZE))
+        {
+            throw IOException("Invalid BGZF block header.");
+        }
+
+        block_offset = offset;
+        block_size = (header[16] | (header[17] << 8)) + 1;
+
+        return true;
+    }
+
+    uint32_t BgzfSource::OpenBlock()
+    {
+        // ISIZE, the decompressed size, is the last four bytes of the block.
+        unsigned char trailer[4];
+        if (!input->ReadAt(block_offset + block_size - 4, trailer, 4))
+        {
+            throw IOException("Truncated BGZF block.");
+        }
+
+        // Blocks are at most 64 KiB, a larger buffer would only read ahead into blocks that may be skipped.
+        input->buffer.resize(1 << 16);
+        SeekBlock(block_offset);
+
+        return trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | ((uint32_t)trailer[3] << 24);
+    }
+
+    void BgzfSource::SeekBlock(uint64_t offset)
+    {
+        input->Seek(offset);
+        inflateReset(&stream);
+        finished = false;
+        decompressed = 0;
+
+        blocks.clear();
+        blocks.push_back({offset, 0});
+    }
+
+    bool BgzfSource::Seekable() const
+    {
+        return input->Seekable();
+    }
+
+    void BgzfSource::StartMember()
+    {
+        blocks.push_back({input->Tell(), decompressed});
+    }
+
+    uint64_t BgzfSource::VirtualOffset(uint64_t offset)
+    {
+        while (blocks.size() > 1 && blocks[1].decompressed_offset <= offset)
+        {
+            blocks.pop_front();
+        }
+
+        return (blocks[0].file_offset << 16) | (offset - blocks[0].decompressed_offset);
+    }
+
+    ZstdSource::ZstdSource(unique_ptr<FastxInput> input) : input(std::move(input))
+    {
+        stream = duckdb_zstd::ZSTD_createDStream();
+        if (stream == nullptr)
+        {
+            throw IOException("Unable to initialize zstd decompression.");
+        }
+
+        duckdb_zstd::ZSTD_initDStream((duckdb_zstd::ZSTD_DStream *)stream);
+    }
+
+    ZstdSource::~ZstdSource()
+    {
+        duckdb_zstd::ZSTD_freeDStream((duckdb_zstd::ZSTD_DStream *)stream);
+    }
+
+    int ZstdSource::Read(void *buffer, unsigned int size)
+    {
+        duckdb_zstd::ZSTD_outBuffer out = {buffer, size, 0};
+
+        while (out.pos < out.size)
+        {
+            // A full output buffer may leave decompressed bytes behind in zstd, those are flushed without new input.
+            auto has_input = input->Fill();
+            if (!has_input && !flushing)
+            {
+                CheckEnd();
+                break;
+            }
+
+            auto written = out.pos;
+            duckdb_zstd::ZSTD_inBuffer in = {input->buffer.data(), input->size, input->position};
+
+            auto status = duckdb_zstd::ZSTD_decompressStream((duckdb_zstd::ZSTD_DStream *)stream, &out, &in);
+            if (duckdb_zstd::ZSTD_isError(status))
+            {
+                throw IOException("Invalid zstd data: " + std::string(duckdb_zstd::ZSTD_getErrorName(status)));
+            }
+
+            input->position = in.pos;
+            flushing = out.pos == out.size;
+            // 0 once a frame is fully decoded and flushed, anything else means the frame continues.
+            in_frame = status != 0;
+
+            if (!has_input && out.pos == written)
+            {
+                CheckEnd();
+                break;
+            }
+        }
+
+        return out.pos;
+    }
+
+    void ZstdSource::CheckEnd()
+    {
+        if (in_frame)
+        {
+            throw IOException("Unexpected end of zstd data.");
+        }
+    }
+
+}
@@ -0,0 +1,387 @@
+#include <duckdb.hpp>
+#include <duckdb/common/string_util.hpp>
+#include <duckdb/main/config.hpp>
+
+#include <cstring>
+#include <string>
+
+#include "fastx_writer.hpp"
+
+#include "zstd.h"
+
+using namespace duckdb;
+namespace fasql
+{
+
+    static constexpr size_t OUTPUT_BUFFER_SIZE = 1 << 18;
+
+    FastxWriteOptions FastxWriteOptions::FromCopyInfo(CopyInfo &info, const std::string &format)
+    {
+        FastxWriteOptions options;
+
+        for (auto &option : info.options)
+        {
+            auto name = StringUtil::Lower(option.first);
+            if (option.second.size() != 1)
+            {
+                throw BinderException(option.first + " expects a single value for " + format + " COPY.");
+            }
+
+            auto &value = option.second[0];
+            if (name == "records_per_file")
+            {
+                auto records = value.GetValue<int64_t>();
+                if (records < 1)
+                {
+                    throw BinderException("RECORDS_PER_FILE must be at least 1.");
+                }
+                options.records_per_file = records;
+            }
+            else if (name == "file_size_bytes")
+            {
+                if (value.type().id() == LogicalTypeId::VARCHAR)
+                {
+                    // ParseMemoryLimit gives INVALID_INDEX for a negative size, which means no limit for DuckDB's memory.
+                    options.file_size_bytes = DBConfig::ParseMemoryLimit(value.ToString());
+                    if (options.file_size_bytes == 0 || options.file_size_bytes == DConstants::INVALID_INDEX)
+                    {
+                        throw BinderException("FILE_SIZE_BYTES must be at least 1 byte.");
+                    }
+                }
+                else
+                {
+                    auto bytes = value.GetValue<int64_t>();
+                    if (bytes < 1)
+                    {
+                        throw BinderException("FILE_SIZE_BYTES must be at least 1 byte.");
+                    }
+                    options.file_size_bytes = bytes;
+                }
+            }
+            else if (name == "compression")
+            {
+                auto compression = StringUtil::Lower(value.ToString());
+                options.compression_from_extension = compression == "auto";
+                if (compression == "gzip")
+                {
+                    options.compression = FastxCompression::GZIP;
+                }
+                else if (compression == "zstd")
+                {
+                    options.compression = FastxCompression::ZSTD;
+                }
+                else if (compression != "none" && compression != "auto")
+                {
+                    throw BinderException("COMPRESSION for " + format + " COPY must be 'auto', 'none', 'gzip' or 'zstd'.");
+                }
+            }
+            else
+            {
+                throw BinderException("Unrecognized option for " + format + " COPY: " + option.first);
+            }
+        }
+
+        return options;
+    }
+
+    bool FastxWriteOptions::Rotating() const
+    {
+        return records_per_file > 0 || file_size_bytes > 0;
+    }
+
+    idx_t FastxColumnIndex(const vector<std::string> &names, const std::string &name)
+    {
+        for (idx_t i = 0; i < names.size(); i++)
+        {
+            if (names[i] == name)
+            {
+                return i;
+            }
+        }
+
+        return DConstants::INVALID_INDEX;
+    }
+
+    void FastxWriteBuffer::AppendRecord(char marker, string_t id, const string_t *description, string_t sequence, const string_t *quality_scores)
+    {
+        data += marker;
+        data.append(id.GetDataUnsafe(), id.GetSize());
+
+        if (description && description->GetSize() > 0)
+        {
+            data += ' ';
+            data.append(description->GetDataUnsafe(), description->GetSize());
+        }
+
+        data += '\n';
+        data.append(sequence.GetDataUnsafe(), sequence.GetSize());
+        data += '\n';
+
+        if (quality_scores)
+        {
+            data += "+\n";
+            data.append(quality_scores->GetDataUnsafe(), quality_scores->GetSize());
+            data += '\n';
+        }
+
+        record_ends.push_back(data.size());
+    }
+
+    void FastxWriteBuffer::Clear()
+    {
+        data.clear();
+        record_ends.clear();
+    }
+
+    FastxOutput::FastxOutput(const std::string &path) : path(path)
+    {
+        file = path == "-" ? stdout : fopen(path.c_str(), "wb");
+        if (file == nullptr)
+        {
+            throw IOException("Unable to open file for writing: " + path);
+        }
+    }
+
+    FastxOutput::~FastxOutput()
+    {
+        if (file && file != stdout)
+        {
+            fclose(file);
+        }
+    }
+
+    unique_ptr<FastxOutput> FastxOutput::Open(const std::string &path)
+    {
+        if (StringUtil::EndsWith(path, ".gz"))
+        {
+            return Open(path, FastxCompression::GZIP);
+        }
+
+        if (StringUtil::EndsWith(path, ".zst"))
+        {
+            return Open(path, FastxCompression::ZSTD);
+        }
+
+        return Open(path, FastxCompression::NONE);
+    }
+
+    unique_ptr<FastxOutput> FastxOutput::Open(const std::string &path, FastxCompression compression)
+    {
+        switch (compression)
+        {
+        case FastxCompression::GZIP:
+            return make_uniq<GzipOutput>(path);
+        case FastxCompression::ZSTD:
+            return make_uniq<ZstdOutput>(path);
+        default:
+            return make_uniq<FastxOutput>(path);
+        }
+    }
+
+    void FastxOutput::WriteFile(const void *data, size_t size)
+    {
+        if (fwrite(data, 1, size, file) != size)
+        {
+            throw IOException("Unable to write to file: " + path);
+        }
+    }
+
+    void FastxOutput::Write(const char *data, size_t size)
+    {
+        WriteFile(data, size);
+    }
+
+    void FastxOutput::Close()
+    {
+        if (file == nullptr)
+        {
+            return;
+        }
+
+        if (file == stdout)
+        {
+            fflush(file);
+        }
+        else if (fclose(file) != 0)
+        {
+            file = nullptr;
+            throw IOException("Unable to close file: " + path);
+        }
+
+        file = nullptr;
+    }
+
+    GzipOutput::GzipOutput(const std::string &path) : FastxOutput(path), buffer(OUTPUT_BUFFER_SIZE)
+    {
+        memset(&stream, 0, sizeof(stream));
+
+        // 15 + 16 writes a gzip wrapper rather than a zlib one.
+        if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            throw IOException("Unable to initialize gzip compression.");
+        }
+    }
+
+    GzipOutput::~GzipOutput()
+    {
+        deflateEnd(&stream);
+    }
+
+    void GzipOutput::Deflate(int flush)
+    {
+        do
+        {
+            stream.next_out = buffer.data();
+            stream.avail_out = buffer.size();
+
+            auto status = deflate(&stream, flush);
+            if (status == Z_STREAM_ERROR)
+            {
+                throw IOException("Unable to compress data for " + path);
+            }
+
+            WriteFile(buffer.data(), buffer.size() - stream.avail_out);
+        } while (stream.avail_out == 0);
+    }
+
+    void GzipOutput::Write(const char *data, size_t size)
+    {
+        stream.next_in = (Bytef *)data;
+        stream.avail_in = size;
+        Deflate(Z_NO_FLUSH);
+    }
+
+    void GzipOutput::Close()
+    {
+        stream.next_in = nullptr;
+        stream.avail_in = 0;
+        Deflate(Z_FINISH);
+        FastxOutput::Close();
+    }
+
+    ZstdOutput::ZstdOutput(const std::string &path) : FastxOutput(path), buffer(duckdb_zstd::ZSTD_CStreamOutSize())
+    {
+        stream = duckdb_zstd::ZSTD_createCStream();
+        if (stream == nullptr)
+        {
+            throw IOException("Unable to initialize zstd compression.");
+        }
+
+        duckdb_zstd::ZSTD_initCStream((duckdb_zstd::ZSTD_CStream *)stream, ZSTD_CLEVEL_DEFAULT);
+    }
+
+    ZstdOutput::~ZstdOutput()
+    {
+        duckdb_zstd::ZSTD_freeCStream((duckdb_zstd::ZSTD_CStream *)stream);
+    }
+
+    void ZstdOutput::Write(const char *data, size_t size)
+    {
+        duckdb_zstd::ZSTD_inBuffer in = {data, size, 0};
+
+        while (in.pos < in.size)
+        {
+            duckdb_zstd::ZSTD_outBuffer out = {buffer.data(), buffer.size(), 0};
+
+            auto status = duckdb_zstd::ZSTD_compressStream((duckdb_zstd::ZSTD_CStream *)stream, &out, &in);
+            if (duckdb_zstd::ZSTD_isError(status))
+            {
+                throw IOException("Unable to compress data for " + path + ": " + duckdb_zstd::ZSTD_getErrorName(status));
+            }
+
+            WriteFile(buffer.data(), out.pos);
+        }
+    }
+
+    void ZstdOutput::Close()
+    {
+        size_t remaining;
+        do
+        {
+            duckdb_zstd::ZSTD_outBuffer out = {buffer.data(), buffer.size(), 0};
+
+            remaining = duckdb_zstd::ZSTD_endStream((duckdb_zstd::ZSTD_CStream *)stream, &out);
+            if (duckdb_zstd::ZSTD_isError(remaining))
+            {
+                throw IOException("Unable to compress data for " + path + ": " + duckdb_zstd::ZSTD_getErrorName(remaining));
+            }
+
+            WriteFile(buffer.data(), out.pos);
+        } while (remaining > 0);
+
+        FastxOutput::Close();
+    }
+
+    FastxWriter::FastxWriter(const std::string &path, const FastxWriteOptions &options) : path(path), options(options)
+    {
+        output = Open(options.Rotating() ? RotatedPath(path, 0) : path);
+    }
+
+    unique_ptr<FastxOutput> FastxWriter::Open(const std::string &file_path) const
+    {
+        // PARTITION_BY and PER_THREAD_OUTPUT name files .fasta or .fastq, COMPRESSION is the only way to compress those.
+        return options.compression_from_extension ? FastxOutput::Open(file_path) : FastxOutput::Open(file_path, options.compression);
+    }
+
+    std::string FastxWriter::RotatedPath(const std::string &path, idx_t n)
+    {
+        auto directory_end = path.find_last_of("/\\");
+        auto name_start = directory_end == std::string::npos ? 0 : directory_end + 1;
+
+        auto extension_start = path.find('.', name_start + 1);
+        if (extension_start == std::string::npos)
+        {
+            return path + "_" + std::to_string(n);
+        }
+
+        return path.substr(0, extension_start) + "_" + std::to_string(n) + path.substr(extension_start);
+    }
+
+    void FastxWriter::Rotate()
+    {
+        output->Close();
+
+        file_index++;
+        file_records = 0;
+        file_bytes = 0;
+        output = Open(RotatedPath(path, file_index));
+    }
+
+    void FastxWriter::Write(const FastxWriteBuffer &buffer)
+    {
+        if (!options.Rotating())
+        {
+            output->Write(buffer.data.data(), buffer.data.size());
+            return;
+        }
+
+        // Write runs of records that fit in the current file, rotating in between.
+        size_t start = 0;
+        size_t run_start = 0;
+
+        for (auto end : buffer.record_ends)
+        {
+            auto full = (options.records_per_file > 0 && file_records >= options.records_per_file) ||
+                        (options.file_size_bytes > 0 && file_records > 0 && file_bytes >= options.file_size_bytes);
+
+            if (full)
+            {
+                output->Write(buffer.data.data() + run_start, start - run_start);
+                Rotate();
+                run_start = start;
+            }
+
+            file_bytes += end - start;
+            file_records++;
+            start = end;
+        }
+
+        output->Write(buffer.data.data() + run_start, start - run_start);
+    }
+
+    void FastxWriter::Close()
+    {
+        output->Close();
+    }
+
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <duckdb.hpp>
+
+#include <duckdb/parser/parsed_data/create_aggregate_function_info.hpp>
+
+using namespace duckdb;
+namespace fasql
+{
+
+    class AggregateFunctions
+    {
+    public:
+        static unique_ptr<CreateAggregateFunctionInfo> GetFastqQcFunction();
+        static unique_ptr<CreateAggregateFunctionInfo> GetKmerBloomBuildFunction();
+        static unique_ptr<CreateAggregateFunctionInfo> GetAssemblyStatsFunction();
+    };
+
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <duckdb.hpp>
+
+#include <map>
+
+using namespace duckdb;
+namespace fasql
+{
+
+    // Counters behind the assembly_stats aggregate, sequences are reduced to their length and base counts as they're added.
+    class AssemblyStatsCounts
+    {
+    public:
+        void Add(const char *sequence, idx_t length);
+        void Merge(const AssemblyStatsCounts &other);
+
+        Value Finalize() const;
+        static LogicalType ResultType();
+
+    private:
+        uint64_t contigs = 0;
+        uint64_t total_length = 0;
+        uint64_t gc_bases = 0;
+        // Bases other than A, C, G or T, such as the Ns of scaffold gaps.
+        uint64_t other_bases = 0;
+
+        // Contigs by length, assemblies have far fewer distinct lengths than bases so this stays small.
+        std::map<uint64_t, uint64_t> lengths;
+    };
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <duckdb.hpp>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace duckdb;
+namespace fasql
+{
+
+    // Assigns reads to the closest of a set of equal length barcodes, allowing up to max_mismatches substitutions.
+    class BarcodeIndex
+    {
+    public:
+        static constexpr idx_t MAX_LENGTH = 32;
+        static constexpr int64_t NO_MATCH = -1;
+
+        BarcodeIndex(const std::vector<std::string> &barcodes, idx_t max_mismatches);
+
+        // Returns the index of the barcode matching the first Length() bases of sequence, or NO_MATCH if none is
+        // within max_mismatches or several are equally close.
+        int64_t Match(const char *sequence, idx_t size) const;
+
+        idx_t Length() const;
+        const std::vector<std::string> &Barcodes() const;
+        idx_t MaxMismatches() const;
+
+    private:
+        struct Neighbor
+        {
+            uint32_t barcode;
+            uint32_t distance;
+        };
+
+        static constexpr uint32_t AMBIGUOUS = UINT32_MAX;
+
+        // Packs 2 bits per base, unknown gets the low bit of each base that isn't A, C, G or T.
+        static void Pack(const char *sequence, idx_t length, uint64_t &packed, uint64_t &unknown);
+        static idx_t Distance(uint64_t a, uint64_t b, uint64_t unknown);
+
+        void AddNeighbors(uint64_t key, uint32_t barcode, idx_t start, uint32_t distance);
+        int64_t Scan(uint64_t packed, uint64_t unknown) const;
+
+        std::vector<std::string> barcodes;
+        std::vector<uint64_t> packed;
+        idx_t length = 0;
+        idx_t max_mismatches;
+
+        // Every sequence within max_mismatches of a barcode mapped to the closest one, only built while that stays small.
+        bool indexed = false;
+        std::unordered_map<uint64_t, Neighbor> neighbors;
+    };
+
+}
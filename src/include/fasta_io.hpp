@@ -1,7 +1,5 @@
 #include <duckdb.hpp>
 
-#include <kseq++/seqio.hpp>
-
 #include <duckdb/parser/parsed_data/create_copy_function_info.hpp>
 #include <duckdb/parser/parsed_data/create_scalar_function_info.hpp>
 #include <duckdb/parser/parsed_data/create_table_function_info.hpp>
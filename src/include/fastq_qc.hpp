@@ -0,0 +1,53 @@
+#pragma once
+
+#include <duckdb.hpp>
+
+#include <map>
+#include <vector>
+
+using namespace duckdb;
+namespace fasql
+{
+
+    // Counters behind the fastq_qc aggregate, everything the report needs is derived from these at the end.
+    class FastqQcCounts
+    {
+    public:
+        // Phred scores above this are counted as this.
+        static constexpr idx_t MAX_QUALITY = 93;
+        static constexpr idx_t QUALITY_BINS = MAX_QUALITY + 1;
+        // A, C, G, T and anything else.
+        static constexpr idx_t BASES = 5;
+        // Positions below this get their own counters, later ones share bins that double in width.
+        static constexpr idx_t EXACT_POSITIONS = 1000;
+
+        // Counts one read, quality may be nullptr for reads without quality scores.
+        void Add(const char *sequence, idx_t length, const char *quality, idx_t quality_length);
+        void Merge(const FastqQcCounts &other);
+
+        Value Finalize() const;
+        static LogicalType ResultType();
+
+    private:
+        // Bin counting position, and the first position after the bin.
+        static idx_t BinOf(idx_t position);
+        static idx_t BinEnd(idx_t bin);
+        void Grow(idx_t count);
+
+        uint64_t reads = 0;
+        uint64_t bases = 0;
+        uint64_t gc_bases = 0;
+        uint64_t quality_bases = 0;
+        uint64_t quality_sum = 0;
+
+        // Indexed by bin * QUALITY_BINS + score and bin * BASES + base.
+        std::vector<uint64_t> quality_counts;
+        std::vector<uint64_t> base_counts;
+        idx_t bins = 0;
+
+        std::map<uint64_t, uint64_t> lengths;
+        // Reads by their mean quality, rounded down.
+        std::vector<uint64_t> mean_qualities = std::vector<uint64_t>(QUALITY_BINS);
+    };
+
+}
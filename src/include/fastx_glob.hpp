@@ -0,0 +1,30 @@
+#pragma once
+
+#include <duckdb.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace duckdb;
+namespace fasql
+{
+
+    // Expands the files argument of read_fasta and read_fastq, a glob or a list of paths and globs.
+    class FastxGlob
+    {
+    public:
+        // Paths matching pattern, a pattern with wildcards in its directories has each matching directory globbed in parallel.
+        static std::vector<std::string> Expand(ClientContext &context, const std::string &pattern);
+
+        // Every pattern is globbed in parallel, throws if a path without wildcards doesn't exist.
+        static std::vector<std::string> Expand(ClientContext &context, const std::vector<std::string> &patterns);
+
+        // The files of a scan's VARCHAR or LIST(VARCHAR) argument, throws if there are none.
+        static std::vector<std::string> FromInput(ClientContext &context, const Value &input);
+
+        // Argument of the scan a replacement scan on table_name becomes, NULL if table_name is a path to a missing file.
+        // Globs are passed on as they are and only expanded at bind.
+        static Value ReplacementArgument(ClientContext &context, const std::string &table_name);
+    };
+
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <duckdb.hpp>
+#include <duckdb/common/named_parameter_map.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "fastx_reader.hpp"
+
+using namespace duckdb;
+namespace fasql
+{
+
+    enum class FastxHeaderFormat
+    {
+        NONE,
+        ILLUMINA,
+        UNIPROT,
+        NCBI
+    };
+
+    // Splits structured record headers into typed fields, fields are only converted to values when asked for.
+    class FastxHeaderParser
+    {
+    public:
+        FastxHeaderParser(FastxHeaderFormat format);
+
+        // Parses the header_format named parameter of read_fasta and read_fastq.
+        static FastxHeaderFormat FromParameters(named_parameter_map_t &parameters);
+
+        // Appends the columns of format to the scan's return types and names.
+        static void AddColumns(FastxHeaderFormat format, vector<LogicalType> &return_types, vector<string> &names);
+
+        // Finds where each field sits in the record's id and description, record must outlive the following Field calls.
+        void Split(const FastxRecord &record);
+
+        // Converts field n of the last split header, NULL if the header doesn't have it, it's empty or it doesn't parse.
+        Value Field(idx_t n) const;
+
+    private:
+        void SplitIllumina(const FastxRecord &record);
+        void SplitUniprot(const FastxRecord &record);
+        void SplitNcbi(const FastxRecord &record);
+
+        FastxHeaderFormat format;
+        std::vector<std::string_view> fields;
+    };
+
+}
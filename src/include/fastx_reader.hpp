@@ -0,0 +1,158 @@
+#pragma once
+
+#include <duckdb.hpp>
+#include <duckdb/common/named_parameter_map.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "fastx_source.hpp"
+
+using namespace duckdb;
+namespace fasql
+{
+
+    class MotifMatcher;
+
+    enum class FastxFormat
+    {
+        FASTA,
+        FASTQ
+    };
+
+    struct FastxRecord
+    {
+        std::string name;
+        std::string comment;
+        std::string seq;
+        std::string qual;
+        // Where the record starts, a byte offset into the decompressed file or a virtual offset for BGZF files.
+        uint64_t offset = 0;
+    };
+
+    // Row sampling applied while parsing, either a fraction of the records or a fixed number of them.
+    struct FastxSampleOptions
+    {
+        double fraction = 1.0;
+        idx_t count = 0;
+
+        // Parses the sample and seed named parameters of read_fasta and read_fastq.
+        static FastxSampleOptions FromParameters(named_parameter_map_t &parameters, std::mt19937_64 &rng);
+    };
+
+    // Read trimming applied as records are parsed, reads left shorter than min_length are dropped.
+    struct FastxTrimOptions
+    {
+        // Phred score cutoff for trimming the 3' end, 0 leaves the qualities alone.
+        int32_t quality = 0;
+        std::string adapter;
+        // Mismatches allowed per adapter base compared, cutadapt's default.
+        double error_rate = 0.1;
+        idx_t min_length = 0;
+
+        // Parses the trim_quality, trim_adapter, adapter_error_rate and min_length named parameters of read_fastq.
+        static FastxTrimOptions FromParameters(named_parameter_map_t &parameters);
+
+        bool Enabled() const;
+
+        // Trims record in place, returns false if it should be dropped.
+        bool Apply(FastxRecord &record) const;
+    };
+
+    // Parses FASTA and FASTQ records from a decompressed source, following the same rules as kseq.
+    class FastxReader
+    {
+    public:
+        FastxReader(const std::string &path, FastxFormat format);
+        // Detects the format from the first record, FASTA if it starts with '>' and FASTQ otherwise.
+        FastxReader(const std::string &path);
+        FastxReader(const std::string &path, FastxFormat format, const FastxSampleOptions &sample, std::mt19937_64 &rng);
+
+        // Parses the next record into record, returns false at the end of the file.
+        bool Next(FastxRecord &record);
+
+        void SetTrim(const FastxTrimOptions &trim);
+
+        // Only records whose sequence matches motif are returned, motif must outlive the reader.
+        void SetMotif(const MotifMatcher *motif);
+
+        // Moves past the record Next would return, returns false at the end of the file. Without trimming or a motif
+        // nothing is copied.
+        bool Skip();
+
+        // Positions the reader so the next record is the one at offset, as reported in FastxRecord::offset.
+        void Seek(uint64_t offset);
+
+    private:
+        void Reset(uint64_t offset);
+        bool Fill();
+        int Peek();
+        size_t ReadLine(std::string *line);
+        bool FindHeader();
+        void ParseRecord(FastxRecord *record);
+        bool NextRecord(FastxRecord &record);
+        // Moves past the next record in the file, whether or not it would be trimmed away or filtered out.
+        bool SkipRecord();
+
+        bool NextBlock();
+        bool Resync();
+
+        std::string path;
+        unique_ptr<FastxSource> source;
+        FastxFormat format;
+
+        std::vector<char> buffer;
+        size_t position = 0;
+        size_t size = 0;
+        // Decompressed offset of buffer[0].
+        uint64_t buffer_offset = 0;
+
+        // Set while looking ahead for a record start, bytes from the mark onwards are kept on refill.
+        bool marked = false;
+        size_t mark = 0;
+
+        double fraction = 1.0;
+        std::mt19937_64 *rng = nullptr;
+
+        // Set for BGZF files, whose offsets are virtual offsets.
+        BgzfSource *bgzf = nullptr;
+        // File offset of the BGZF block Seek last started inflating, decompressed offsets count from its start.
+        uint64_t seek_block = DConstants::INVALID_INDEX;
+
+        // BGZF block sampling, records are read from whole blocks picked with probability fraction.
+        bool block_sampling = false;
+        bool in_block = false;
+        uint64_t block_end = 0;
+
+        FastxTrimOptions trim;
+        const MotifMatcher *motif = nullptr;
+
+        std::string header;
+        // Records Skip has to parse to filter, kept to reuse its buffers.
+        FastxRecord skipped;
+    };
+
+    // Keeps a uniform sample of a fixed number of records, the records that are not picked are only skipped over.
+    class FastxReservoir
+    {
+    public:
+        FastxReservoir(idx_t count, std::mt19937_64 &rng);
+
+        // Feeds every remaining record of reader through the reservoir.
+        void Add(FastxReader &reader, idx_t file_index);
+
+        std::vector<FastxRecord> records;
+        std::vector<idx_t> file_indexes;
+
+    private:
+        idx_t count;
+        std::mt19937_64 &rng;
+        // Number of records to skip before the next one replaces a sampled record, following Algorithm L.
+        idx_t gap = 0;
+        double weight = 0;
+
+        void NextGap();
+    };
+
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <duckdb.hpp>
+
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+using namespace duckdb;
+namespace fasql
+{
+
+    enum class FastxCompression
+    {
+        NONE,
+        GZIP,
+        ZSTD
+    };
+
+    // The raw, still compressed, bytes of a FASTX file.
+    class FastxInput
+    {
+    public:
+        FastxInput(const std::string &path);
+        ~FastxInput();
+
+        // Refills the buffer once it has been fully consumed, returns false at the end of the file.
+        bool Fill();
+
+        // Repositions the file, discarding any buffered bytes.
+        void Seek(uint64_t offset);
+
+        // Reads exactly size bytes at offset bypassing the buffer, returns false if the file is shorter.
+        bool ReadAt(uint64_t offset, unsigned char *data, size_t size);
+
+        // File offset of buffer[position].
+        uint64_t Tell() const;
+
+        // False for pipes and stdin, which can only be read front to back once.
+        bool Seekable() const;
+
+        std::vector<unsigned char> buffer;
+        size_t position = 0;
+        size_t size = 0;
+        // File offset of buffer[0].
+        uint64_t buffer_offset = 0;
+
+    private:
+        FILE *file;
+        std::string path;
+        bool seekable;
+    };
+
+    // A decompressed byte stream over a FASTX file, the compression is detected from the magic bytes.
+    class FastxSource
+    {
+    public:
+        virtual ~FastxSource() = default;
+
+        // Reads up to size decompressed bytes into buffer, returns the number of bytes read or 0 at the end of the file.
+        virtual int Read(void *buffer, unsigned int size) = 0;
+
+        static unique_ptr<FastxSource> Open(const std::string &path);
+        static FastxCompression DetectCompression(const unsigned char *magic, size_t size);
+
+        // True for stdin ("-" or /dev/stdin), file descriptor paths such as process substitutions, named pipes and
+        // character devices such as /dev/null.
+        // These aren't regular files, so they are passed through rather than globbed.
+        static bool IsStream(const std::string &path);
+    };
+
+    class PlainSource : public FastxSource
+    {
+    public:
+        PlainSource(unique_ptr<FastxInput> input);
+        int Read(void *buffer, unsigned int size) override;
+
+        void Seek(uint64_t offset);
+
+    private:
+        unique_ptr<FastxInput> input;
+    };
+
+    // Inflates gzip files, including multi-member files such as BGZF.
+    class GzipSource : public FastxSource
+    {
+    public:
+        GzipSource(unique_ptr<FastxInput> input);
+        ~GzipSource() override;
+        int Read(void *buffer, unsigned int size) override;
+
+    protected:
+        // Called whenever a new gzip member starts after the first.
+        virtual void StartMember()
+        {
+        }
+
+        unique_ptr<FastxInput> input;
+        z_stream stream;
+        bool finished = false;
+        // Decompressed bytes produced so far.
+        uint64_t decompressed = 0;
+    };
+
+    // Gives block level access to BGZF files so blocks can be skipped without being read or inflated.
+    class BgzfSource : public GzipSource
+    {
+    public:
+        BgzfSource(unique_ptr<FastxInput> input);
+
+        static bool IsBgzf(const unsigned char *header, size_t size);
+
+        // Moves to the next block using only its header, returns false after the last block.
+        bool NextBlock();
+
+        // Starts inflating at the current block, returns its decompressed size. Reads continue into the following blocks.
+        uint32_t OpenBlock();
+
+        // Starts inflating at the block at the given file offset, decompressed offsets restart from 0.
+        void SeekBlock(uint64_t offset);
+
+        bool Seekable() const;
+
+        // Converts a decompressed offset into a BGZF virtual offset, the block offset shifted left 16 bits plus the
+        // offset within the block. Offsets must not decrease between calls.
+        uint64_t VirtualOffset(uint64_t offset);
+
+    protected:
+        void StartMember() override;
+
+    private:
+        struct Block
+        {
+            uint64_t file_offset;
+            uint64_t decompressed_offset;
+        };
+
+        uint64_t block_offset = 0;
+        uint64_t block_size = 0;
+        bool started = false;
+
+        // Blocks that may still hold bytes not yet handed to VirtualOffset.
+        std::deque<Block> blocks;
+    };
+
+    // Decompresses zstd files using the zstd library bundled with DuckDB.
+    class ZstdSource : public FastxSource
+    {
+    public:
+        ZstdSource(unique_ptr<FastxInput> input);
+        ~ZstdSource() override;
+        int Read(void *buffer, unsigned int size) override;
+
+    private:
+        // Throws if the input ended part way through a frame.
+        void CheckEnd();
+
+        unique_ptr<FastxInput> input;
+        void *stream;
+        bool flushing = false;
+        bool in_frame = false;
+    };
+
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <duckdb.hpp>
+#include <duckdb/parser/parsed_data/copy_info.hpp>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+#include "fastx_source.hpp"
+
+using namespace duckdb;
+namespace fasql
+{
+
+    // Output rotation and compression for COPY TO, 0 means unlimited.
+    struct FastxWriteOptions
+    {
+        idx_t records_per_file = 0;
+        idx_t file_size_bytes = 0;
+
+        // Set by COMPRESSION, otherwise each file is compressed according to its extension.
+        bool compression_from_extension = true;
+        FastxCompression compression = FastxCompression::NONE;
+
+        // Parses the RECORDS_PER_FILE, FILE_SIZE_BYTES and COMPRESSION options, FILE_SIZE_BYTES also takes sizes such as
+        // '100MB'.
+        static FastxWriteOptions FromCopyInfo(CopyInfo &info, const std::string &format);
+
+        // True if the output is split into numbered files.
+        bool Rotating() const;
+    };
+
+    // Returns the index of the column called name, or DConstants::INVALID_INDEX if there is none.
+    idx_t FastxColumnIndex(const vector<std::string> &names, const std::string &name);
+
+    // Records formatted by one thread, flushed to the shared writer in batches.
+    struct FastxWriteBuffer
+    {
+        static constexpr size_t FLUSH_SIZE = 1 << 20;
+
+        std::string data;
+        // End offset of every record in data, the writer only rotates files on these boundaries.
+        std::vector<size_t> record_ends;
+
+        void AppendRecord(char marker, string_t id, const string_t *description, string_t sequence, const string_t *quality_scores);
+        void Clear();
+    };
+
+    // A single output file, compressed according to its extension.
+    class FastxOutput
+    {
+    public:
+        FastxOutput(const std::string &path);
+        virtual ~FastxOutput();
+
+        virtual void Write(const char *data, size_t size);
+        virtual void Close();
+
+        static unique_ptr<FastxOutput> Open(const std::string &path);
+        static unique_ptr<FastxOutput> Open(const std::string &path, FastxCompression compression);
+
+    protected:
+        void WriteFile(const void *data, size_t size);
+
+        FILE *file;
+        std::string path;
+    };
+
+    class GzipOutput : public FastxOutput
+    {
+    public:
+        GzipOutput(const std::string &path);
+        ~GzipOutput() override;
+
+        void Write(const char *data, size_t size) override;
+        void Close() override;
+
+    private:
+        void Deflate(int flush);
+
+        z_stream stream;
+        std::vector<unsigned char> buffer;
+    };
+
+    // Compresses with the zstd library bundled with DuckDB.
+    class ZstdOutput : public FastxOutput
+    {
+    public:
+        ZstdOutput(const std::string &path);
+        ~ZstdOutput() override;
+
+        void Write(const char *data, size_t size) override;
+        void Close() override;
+
+    private:
+        void *stream;
+        std::vector<unsigned char> buffer;
+    };
+
+    // Writes records to path, starting a new numbered file once records_per_file or file_size_bytes is reached.
+    // file_size_bytes counts the records as formatted, before any compression.
+    class FastxWriter
+    {
+    public:
+        FastxWriter(const std::string &path, const FastxWriteOptions &options);
+
+        void Write(const FastxWriteBuffer &buffer);
+        void Close();
+
+        // Inserts _n before the extensions of path, reads.fastq.gz becomes reads_3.fastq.gz.
+        static std::string RotatedPath(const std::string &path, idx_t n);
+
+    private:
+        void Rotate();
+        unique_ptr<FastxOutput> Open(const std::string &file_path) const;
+
+        std::string path;
+        FastxWriteOptions options;
+
+        unique_ptr<FastxOutput> output;
+        idx_t file_index = 0;
+        idx_t file_records = 0;
+        uint64_t file_bytes = 0;
+    };
+
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <duckdb.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace duckdb;
+namespace fasql
+{
+
+    // Blocked Bloom filter over canonical k-mers, every k-mer sets its bits in one 512 bit block so a probe reads a single
+    // cache line.
+    class KmerBloomFilter
+    {
+    public:
+        static constexpr idx_t MAX_K = 32;
+        static constexpr idx_t BLOCK_WORDS = 8;
+        static constexpr idx_t HEADER_SIZE = 16;
+
+        // Sized for kmers distinct k-mers at roughly fp_rate false positives.
+        KmerBloomFilter(idx_t k, idx_t kmers, double fp_rate);
+
+        // Reads a filter written by Serialize, throws if blob isn't one.
+        static KmerBloomFilter Deserialize(const char *blob, idx_t size);
+        std::string Serialize() const;
+
+        // Calls visit with the hash of every canonical k-mer in sequence, k-mers with bases other than A, C, G or T are skipped.
+        template <class VISIT>
+        static void ForEachKmer(const char *sequence, idx_t size, idx_t k, VISIT &&visit);
+
+        void Add(uint64_t hash);
+        bool Contains(uint64_t hash) const;
+
+        // Adds every k-mer of sequence.
+        void Insert(const char *sequence, idx_t size);
+        // Sets the bits of other, a filter of the same k and size, so the result holds the k-mers of both.
+        void Merge(const KmerBloomFilter &other);
+
+        // Number of k-mers of sequence in the filter, counting repeats.
+        idx_t Hits(const char *sequence, idx_t size) const;
+
+        idx_t K() const;
+
+    private:
+        KmerBloomFilter() = default;
+
+        idx_t k = 0;
+        idx_t hashes = 0;
+        idx_t blocks = 0;
+        std::vector<uint64_t> words;
+    };
+
+    static inline uint64_t KmerHash(uint64_t kmer)
+    {
+        // MurmurHash3 finalizer, packed k-mers are far from uniform.
+        kmer ^= kmer >> 33;
+        kmer *= 0xff51afd7ed558ccdULL;
+        kmer ^= kmer >> 33;
+        kmer *= 0xc4ceb9fe1a85ec53ULL;
+        kmer ^= kmer >> 33;
+        return kmer;
+    }
+
+    template <class VISIT>
+    void KmerBloomFilter::ForEachKmer(const char *sequence, idx_t size, idx_t k, VISIT &&visit)
+    {
+        auto mask = k == MAX_K ? ~0ULL : (1ULL << (2 * k)) - 1;
+        auto shift = 2 * (k - 1);
+        uint64_t forward = 0;
+        uint64_t reverse = 0;
+        idx_t valid = 0;
+
+        for (idx_t i = 0; i < size; i++)
+        {
+            uint64_t code;
+            switch (sequence[i])
+            {
+            case 'A':
+            case 'a':
+                code = 0;
+                break;
+            case 'C':
+            case 'c':
+                code = 1;
+                break;
+            case 'G':
+            case 'g':
+                code = 2;
+                break;
+            case 'T':
+            case 't':
+                code = 3;
+                break;
+            default:
+                valid = 0;
+                continue;
+            }
+
+            forward = ((forward << 2) | code) & mask;
+            reverse = (reverse >> 2) | ((3 - code) << shift);
+
+            if (++valid >= k)
+            {
+                visit(KmerHash(forward < reverse ? forward : reverse));
+            }
+        }
+    }
+
+}
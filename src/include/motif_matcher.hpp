@@ -0,0 +1,46 @@
+#pragma once
+
+#include <duckdb.hpp>
+#include <duckdb/planner/operator/logical_get.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace duckdb;
+namespace fasql
+{
+
+    // Aho-Corasick automaton over nucleotide patterns, IUPAC ambiguity codes are expanded into every base they stand for.
+    class MotifMatcher
+    {
+    public:
+        static constexpr idx_t MAX_EXPANSIONS = 1 << 16;
+
+        MotifMatcher(const std::vector<std::string> &patterns, bool reverse_complement);
+
+        // Returns true if any pattern occurs in sequence, bases other than A, C, G, T and U never match.
+        bool Matches(const char *sequence, idx_t size) const;
+
+        const std::vector<std::string> &Patterns() const;
+        bool ReverseComplement() const;
+
+        // Removes a seq_find_any(sequence, ...) filter on the scan's sequence column from filters and returns its matcher,
+        // or nullptr if there is none with constant arguments.
+        static unique_ptr<MotifMatcher> FromFilters(ClientContext &context, LogicalGet &get, vector<unique_ptr<Expression>> &filters);
+
+    private:
+        static constexpr idx_t ALPHABET = 4;
+
+        void Add(const std::string &pattern);
+        void Build();
+
+        std::vector<std::string> patterns;
+        bool reverse_complement;
+
+        // Dense transitions, state * ALPHABET + base, filled in for every state once Build has run.
+        std::vector<uint32_t> transitions;
+        // Set for states where some pattern ends, directly or through their failure links.
+        std::vector<uint8_t> accepting;
+    };
+
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <duckdb.hpp>
+
+#include <duckdb/parser/parsed_data/create_scalar_function_info.hpp>
+
+using namespace duckdb;
+namespace fasql
+{
+
+    class ScalarFunctions
+    {
+    public:
+        static unique_ptr<CreateScalarFunctionInfo> GetFastxFetchFunction();
+        static unique_ptr<CreateScalarFunctionInfo> GetBarcodeMatchFunction();
+        static unique_ptr<CreateScalarFunctionInfo> GetSeqFindAnyFunction();
+        static unique_ptr<CreateScalarFunctionInfo> GetKmerBloomHitsFunction();
+    };
+
+}
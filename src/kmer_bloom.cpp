@@ -0,0 +1,146 @@
+#include <duckdb.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+#include "kmer_bloom.hpp"
+
+using namespace duckdb;
+namespace fasql
+{
+
+    static constexpr char MAGIC[4] = {'K', 'M', 'B', 'F'};
+    static constexpr uint8_t VERSION = 1;
+    static constexpr idx_t BLOCK_BITS = KmerBloomFilter::BLOCK_WORDS * 64;
+    static constexpr idx_t MAX_HASHES = 16;
+    static constexpr double BLOCK_OVERHEAD = 1.15;
+
+    KmerBloomFilter::KmerBloomFilter(idx_t k, idx_t kmers, double fp_rate) : k(k)
+    {
+        // The standard m = -n ln p / ln 2^2 and h = m / n ln 2, with extra bits since uneven block loads raise the rate a bit.
+        auto n = std::max<double>(kmers, 1);
+        auto bits = std::ceil(-n * std::log(fp_rate) / (std::log(2) * std::log(2)));
+
+        blocks = std::max<idx_t>((idx_t)std::ceil(bits * BLOCK_OVERHEAD / BLOCK_BITS), 1);
+        hashes = std::min<idx_t>(std::max<idx_t>((idx_t)std::round(bits / n * std::log(2)), 1), MAX_HASHES);
+        words.resize(blocks * BLOCK_WORDS);
+    }
+
+    KmerBloomFilter KmerBloomFilter::Deserialize(const char *blob, idx_t size)
+    {
+        if (size < HEADER_SIZE || memcmp(blob, MAGIC, sizeof(MAGIC)) != 0 || (uint8_t)blob[4] != VERSION)
+        {
+            throw InvalidInputException("Not a k-mer Bloom filter, filters are made by kmer_bloom_build.");
+        }
+
+        KmerBloomFilter filter;
+        filter.k = (uint8_t)blob[5];
+        filter.hashes = (uint8_t)blob[6];
+
+        uint64_t blocks;
+        memcpy(&blocks, blob + 8, sizeof(blocks));
+        if (filter.k == 0 || filter.k > MAX_K || filter.hashes == 0 || filter.hashes > MAX_HASHES ||
+            blocks == 0 || (size - HEADER_SIZE) / (BLOCK_WORDS * sizeof(uint64_t)) != blocks || (size - HEADER_SIZE) % (BLOCK_WORDS * sizeof(uint64_t)) != 0)
+        {
+            throw InvalidInputException("Corrupt k-mer Bloom filter.");
+        }
+
+        filter.blocks = blocks;
+        filter.words.resize(blocks * BLOCK_WORDS);
+        memcpy(filter.words.data(), blob + HEADER_SIZE, size - HEADER_SIZE);
+        return filter;
+    }
+
+    std::string KmerBloomFilter::Serialize() const
+    {
+        std::string blob(HEADER_SIZE + words.size() * sizeof(uint64_t), '\0');
+        memcpy(&blob[0], MAGIC, sizeof(MAGIC));
+        blob[4] = (char)VERSION;
+        blob[5] = (char)k;
+        blob[6] = (char)hashes;
+
+        uint64_t block_count = blocks;
+        memcpy(&blob[8], &block_count, sizeof(block_count));
+        memcpy(&blob[HEADER_SIZE], words.data(), words.size() * sizeof(uint64_t));
+        return blob;
+    }
+
+    // The high half of the hash picks the block, a remixed hash gives the double hashing steps inside it.
+    static inline idx_t Block(uint64_t hash, idx_t blocks)
+    {
+        return (idx_t)(((hash >> 32) * blocks) >> 32);
+    }
+
+    static inline uint64_t Probes(uint64_t hash)
+    {
+        return hash * 0x9e3779b97f4a7c15ULL;
+    }
+
+    void KmerBloomFilter::Add(uint64_t hash)
+    {
+        auto block = words.data() + Block(hash, blocks) * BLOCK_WORDS;
+        auto probes = Probes(hash);
+        auto bit = (uint32_t)probes;
+        auto step = (uint32_t)(probes >> 32) | 1;
+
+        for (idx_t i = 0; i < hashes; i++, bit += step)
+        {
+            auto position = bit % BLOCK_BITS;
+            block[position / 64] |= 1ULL << (position % 64);
+        }
+    }
+
+    bool KmerBloomFilter::Contains(uint64_t hash) const
+    {
+        auto block = words.data() + Block(hash, blocks) * BLOCK_WORDS;
+        auto probes = Probes(hash);
+        auto bit = (uint32_t)probes;
+        auto step = (uint32_t)(probes >> 32) | 1;
+
+        for (idx_t i = 0; i < hashes; i++, bit += step)
+        {
+            auto position = bit % BLOCK_BITS;
+            if (!(block[position / 64] & (1ULL << (position % 64))))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    idx_t KmerBloomFilter::Hits(const char *sequence, idx_t size) const
+    {
+        idx_t hits = 0;
+        ForEachKmer(sequence, size, k, [&](uint64_t hash)
+                    { hits += Contains(hash); });
+        return hits;
+    }
+
+    void KmerBloomFilter::Insert(const char *sequence, idx_t size)
+    {
+        ForEachKmer(sequence, size, k, [&](uint64_t hash)
+                    { Add(hash); });
+    }
+
+    void KmerBloomFilter::Merge(const KmerBloomFilter &other)
+    {
+        if (other.k != k || other.hashes != hashes || other.blocks != blocks)
+        {
+            throw InvalidInputException("Can't merge k-mer Bloom filters of different k or size.");
+        }
+
+        for (idx_t i = 0; i < words.size(); i++)
+        {
+            words[i] |= other.words[i];
+        }
+    }
+
+    idx_t KmerBloomFilter::K() const
+    {
+        return k;
+    }
+
+}
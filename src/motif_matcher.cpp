@@ -0,0 +1,316 @@
+#include <duckdb.hpp>
+#include <duckdb/execution/expression_executor.hpp>
+#include <duckdb/planner/expression/bound_columnref_expression.hpp>
+#include <duckdb/planner/expression/bound_function_expression.hpp>
+#include <duckdb/planner/operator/logical_get.hpp>
+
+#include <bitset>
+#include <cctype>
+#include <cstring>
+#include <deque>
+#include <string>
+
+#include "motif_matcher.hpp"
+
+using namespace duckdb;
+namespace fasql
+{
+
+    static constexpr uint32_t NO_STATE = UINT32_MAX;
+
+    // Bases each IUPAC code stands for as a bit set, A = 1, C = 2, G = 4 and T or U = 8.
+    static uint8_t IupacBases(char code)
+    {
+        switch (toupper(code))
+        {
+        case 'A':
+            return 1;
+        case 'C':
+            return 2;
+        case 'G':
+            return 4;
+        case 'T':
+        case 'U':
+            return 8;
+        case 'R':
+            return 1 | 4;
+        case 'Y':
+            return 2 | 8;
+        case 'S':
+            return 2 | 4;
+        case 'W':
+            return 1 | 8;
+        case 'K':
+            return 4 | 8;
+        case 'M':
+            return 1 | 2;
+        case 'B':
+            return 2 | 4 | 8;
+        case 'D':
+            return 1 | 4 | 8;
+        case 'H':
+            return 1 | 2 | 8;
+        case 'V':
+            return 1 | 2 | 4;
+        case 'N':
+            return 1 | 2 | 4 | 8;
+        default:
+            throw InvalidInputException(std::string("Invalid IUPAC code in pattern: ") + code);
+        }
+    }
+
+    // Base codes for the sequence being searched, -1 for anything that isn't A, C, G, T or U.
+    struct BaseCodes
+    {
+        int8_t codes[256];
+
+        BaseCodes()
+        {
+            memset(codes, -1, sizeof(codes));
+            codes['A'] = codes['a'] = 0;
+            codes['C'] = codes['c'] = 1;
+            codes['G'] = codes['g'] = 2;
+            codes['T'] = codes['t'] = 3;
+            codes['U'] = codes['u'] = 3;
+        }
+    };
+
+    static const BaseCodes BASE_CODES;
+
+    MotifMatcher::MotifMatcher(const std::vector<std::string> &patterns, bool reverse_complement)
+        : patterns(patterns), reverse_complement(reverse_complement), transitions(ALPHABET, NO_STATE), accepting(1, false)
+    {
+        idx_t expansions = 0;
+
+        for (auto &pattern : patterns)
+        {
+            std::vector<uint8_t> bases;
+            double count = 1;
+            for (auto code : pattern)
+            {
+                bases.push_back(IupacBases(code));
+                count *= std::bitset<ALPHABET>(bases.back()).count();
+            }
+
+            expansions += (reverse_complement ? 2 : 1) * count;
+            if (count > MAX_EXPANSIONS || expansions > MAX_EXPANSIONS)
+            {
+                throw InvalidInputException("Patterns expand to more than " + std::to_string(MAX_EXPANSIONS) + " sequences, use fewer ambiguity codes.");
+            }
+
+            // Odometer over the choices for every ambiguous position.
+            std::string concrete(pattern.size(), 0);
+            std::vector<uint8_t> choice(pattern.size(), 0);
+            while (true)
+            {
+                for (idx_t i = 0; i < bases.size(); i++)
+                {
+                    idx_t seen = 0;
+                    for (uint8_t code = 0; code < ALPHABET; code++)
+                    {
+                        if ((bases[i] >> code) & 1 && seen++ == choice[i])
+                        {
+                            concrete[i] = code;
+                        }
+                    }
+                }
+
+                Add(concrete);
+                if (reverse_complement)
+                {
+                    std::string complement(concrete.rbegin(), concrete.rend());
+                    for (auto &code : complement)
+                    {
+                        code = 3 - code;
+                    }
+                    Add(complement);
+                }
+
+                idx_t i = 0;
+                for (; i < bases.size(); i++)
+                {
+                    if (++choice[i] < std::bitset<ALPHABET>(bases[i]).count())
+                    {
+                        break;
+                    }
+                    choice[i] = 0;
+                }
+
+                if (i == bases.size())
+                {
+                    break;
+                }
+            }
+        }
+
+        Build();
+    }
+
+    void MotifMatcher::Add(const std::string &pattern)
+    {
+        uint32_t state = 0;
+
+        for (auto code : pattern)
+        {
+            auto &next = transitions[state * ALPHABET + code];
+            if (next == NO_STATE)
+            {
+                next = accepting.size();
+                transitions.resize(transitions.size() + ALPHABET, NO_STATE);
+                accepting.push_back(false);
+            }
+            state = transitions[state * ALPHABET + code];
+        }
+
+        accepting[state] = true;
+    }
+
+    void MotifMatcher::Build()
+    {
+        // Breadth first, so a state's failure link is complete before its children need it.
+        std::vector<uint32_t> failure(accepting.size(), 0);
+        std::deque<uint32_t> queue;
+
+        for (idx_t code = 0; code < ALPHABET; code++)
+        {
+            auto &next = transitions[code];
+            if (next == NO_STATE)
+            {
+                next = 0;
+            }
+            else
+            {
+                queue.push_back(next);
+            }
+        }
+
+        while (!queue.empty())
+        {
+            auto state = queue.front();
+            queue.pop_front();
+            accepting[state] = accepting[state] || accepting[failure[state]];
+
+            for (idx_t code = 0; code < ALPHABET; code++)
+            {
+                auto &next = transitions[state * ALPHABET + code];
+                auto fallback = transitions[failure[state] * ALPHABET + code];
+
+                if (next == NO_STATE)
+                {
+                    next = fallback;
+                }
+                else
+                {
+                    failure[next] = fallback;
+                    queue.push_back(next);
+                }
+            }
+        }
+    }
+
+    bool MotifMatcher::Matches(const char *sequence, idx_t size) const
+    {
+        if (accepting[0])
+        {
+            return true;
+        }
+
+        uint32_t state = 0;
+        auto transition = transitions.data();
+
+        for (idx_t i = 0; i < size; i++)
+        {
+            auto code = BASE_CODES.codes[(unsigned char)sequence[i]];
+            if (code < 0)
+            {
+                state = 0;
+                continue;
+            }
+
+            state = transition[state * ALPHABET + code];
+            if (accepting[state])
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    const std::vector<std::string> &MotifMatcher::Patterns() const
+    {
+        return patterns;
+    }
+
+    bool MotifMatcher::ReverseComplement() const
+    {
+        return reverse_complement;
+    }
+
+    unique_ptr<MotifMatcher> MotifMatcher::FromFilters(ClientContext &context, LogicalGet &get, vector<unique_ptr<Expression>> &filters)
+    {
+        for (idx_t i = 0; i < filters.size(); i++)
+        {
+            if (filters[i]->GetExpressionClass() != ExpressionClass::BOUND_FUNCTION)
+            {
+                continue;
+            }
+
+            auto &function = (BoundFunctionExpression &)*filters[i];
+            auto &children = function.children;
+            if (function.function.name != "seq_find_any" || children[0]->GetExpressionClass() != ExpressionClass::BOUND_COLUMN_REF)
+            {
+                continue;
+            }
+
+            auto &column = (BoundColumnRefExpression &)*children[0];
+            if (column.binding.table_index != get.table_index)
+            {
+                continue;
+            }
+
+            auto column_id = get.column_ids[column.binding.column_index];
+            if (column_id >= get.names.size() || get.names[column_id] != "sequence")
+            {
+                continue;
+            }
+
+            auto foldable = true;
+            for (idx_t j = 1; j < children.size(); j++)
+            {
+                foldable = foldable && children[j]->IsFoldable();
+            }
+            if (!foldable)
+            {
+                continue;
+            }
+
+            // NULL arguments make the filter NULL for every row, that is left to DuckDB.
+            auto pattern_list = ExpressionExecutor::EvaluateScalar(context, *children[1]);
+            auto reverse_complement = children.size() > 2 ? ExpressionExecutor::EvaluateScalar(context, *children[2]) : Value::BOOLEAN(false);
+            if (pattern_list.IsNull() || reverse_complement.IsNull())
+            {
+                continue;
+            }
+
+            std::vector<std::string> patterns;
+            auto has_null = false;
+            for (auto &pattern : ListValue::GetChildren(pattern_list))
+            {
+                has_null = has_null || pattern.IsNull();
+                patterns.push_back(pattern.ToString());
+            }
+            if (has_null)
+            {
+                continue;
+            }
+
+            auto matcher = make_uniq<MotifMatcher>(patterns, reverse_complement.GetValue<bool>());
+            filters.erase(filters.begin() + i);
+            return matcher;
+        }
+
+        return nullptr;
+    }
+
+}
@@ -0,0 +1,449 @@
+#include <duckdb.hpp>
+#include <duckdb/execution/expression_executor_state.hpp>
+#include <duckdb/planner/expression/bound_function_expression.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "scalar_functions.hpp"
+#include "barcode_index.hpp"
+#include "fastx_reader.hpp"
+#include "kmer_bloom.hpp"
+#include "motif_matcher.hpp"
+
+using namespace duckdb;
+namespace fasql
+{
+
+    struct FastxFetchLocalState : public FunctionLocalState
+    {
+        // The last file fetched from is kept open, fetching offsets in order then reads on through bytes already decompressed.
+        // Its format is detected from the file.
+        std::string file_name;
+        unique_ptr<FastxReader> reader;
+        FastxRecord record;
+    };
+
+    static unique_ptr<FunctionLocalState> FastxFetchInitLocalState(ExpressionState &state, const BoundFunctionExpression &expr, FunctionData *bind_data)
+    {
+        return make_uniq<FastxFetchLocalState>();
+    }
+
+    static void FastxFetchFunction(DataChunk &args, ExpressionState &state, Vector &result)
+    {
+        auto &local_state = (FastxFetchLocalState &)*ExecuteFunctionState::GetFunctionState(state);
+        auto count = args.size();
+
+        UnifiedVectorFormat file_name_data;
+        UnifiedVectorFormat offset_data;
+        args.data[0].ToUnifiedFormat(count, file_name_data);
+        args.data[1].ToUnifiedFormat(count, offset_data);
+
+        auto file_names = (string_t *)file_name_data.data;
+        auto offsets = (int64_t *)offset_data.data;
+
+        auto &entries = StructVector::GetEntries(result);
+        auto ids = FlatVector::GetData<string_t>(*entries[0]);
+        auto descriptions = FlatVector::GetData<string_t>(*entries[1]);
+        auto sequences = FlatVector::GetData<string_t>(*entries[2]);
+        auto quality_scores = FlatVector::GetData<string_t>(*entries[3]);
+
+        // Rows are fetched in file and offset order, so a gzip or zstd file is read forwards through the whole chunk
+        // rather than decompressed from the start again for every offset that goes backwards.
+        std::vector<idx_t> rows;
+        for (idx_t i = 0; i < count; i++)
+        {
+            if (!file_name_data.validity.RowIsValid(file_name_data.sel->get_index(i)) || !offset_data.validity.RowIsValid(offset_data.sel->get_index(i)))
+            {
+                FlatVector::SetNull(result, i, true);
+                continue;
+            }
+            rows.push_back(i);
+        }
+
+        std::sort(rows.begin(), rows.end(), [&](idx_t a, idx_t b)
+                  {
+            auto &file_a = file_names[file_name_data.sel->get_index(a)];
+            auto &file_b = file_names[file_name_data.sel->get_index(b)];
+            auto order = memcmp(file_a.GetDataUnsafe(), file_b.GetDataUnsafe(), std::min(file_a.GetSize(), file_b.GetSize()));
+            if (order != 0 || file_a.GetSize() != file_b.GetSize())
+            {
+                return order != 0 ? order < 0 : file_a.GetSize() < file_b.GetSize();
+            }
+            return offsets[offset_data.sel->get_index(a)] < offsets[offset_data.sel->get_index(b)]; });
+
+        for (auto i : rows)
+        {
+            auto file_name_index = file_name_data.sel->get_index(i);
+            auto offset_index = offset_data.sel->get_index(i);
+
+            auto file_name = file_names[file_name_index].GetString();
+            if (!local_state.reader || file_name != local_state.file_name)
+            {
+                local_state.reader = make_uniq<FastxReader>(file_name);
+                local_state.file_name = file_name;
+            }
+
+            auto &record = local_state.record;
+            local_state.reader->Seek(offsets[offset_index]);
+            if (!local_state.reader->Next(record))
+            {
+                throw IOException("No record at offset " + std::to_string(offsets[offset_index]) + " in " + file_name);
+            }
+
+            ids[i] = StringVector::AddString(*entries[0], record.name);
+            sequences[i] = StringVector::AddString(*entries[2], record.seq);
+
+            if (record.comment.empty())
+            {
+                FlatVector::SetNull(*entries[1], i, true);
+            }
+            else
+            {
+                descriptions[i] = StringVector::AddString(*entries[1], record.comment);
+            }
+
+            if (record.qual.empty())
+            {
+                FlatVector::SetNull(*entries[3], i, true);
+            }
+            else
+            {
+                quality_scores[i] = StringVector::AddString(*entries[3], record.qual);
+            }
+        }
+
+        if (args.AllConstant())
+        {
+            result.SetVectorType(VectorType::CONSTANT_VECTOR);
+        }
+    }
+
+    struct BarcodeMatchLocalState : public FunctionLocalState
+    {
+        // Rebuilt only when the barcode list or mismatch limit changes, normally it's the same for the whole query.
+        unique_ptr<BarcodeIndex> index;
+    };
+
+    static unique_ptr<FunctionLocalState> BarcodeMatchInitLocalState(ExpressionState &state, const BoundFunctionExpression &expr, FunctionData *bind_data)
+    {
+        return make_uniq<BarcodeMatchLocalState>();
+    }
+
+    // Compares a list argument to the strings an index was built from, so the index is only rebuilt when the list changes.
+    static bool StringListEquals(const std::vector<std::string> &strings, const list_entry_t &list, UnifiedVectorFormat &list_data)
+    {
+        if (strings.size() != list.length)
+        {
+            return false;
+        }
+
+        auto values = (string_t *)list_data.data;
+        for (idx_t i = 0; i < list.length; i++)
+        {
+            auto value_index = list_data.sel->get_index(list.offset + i);
+            if (!list_data.validity.RowIsValid(value_index))
+            {
+                return false;
+            }
+
+            auto &value = values[value_index];
+            if (value.GetSize() != strings[i].size() || memcmp(value.GetDataUnsafe(), strings[i].data(), value.GetSize()) != 0)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    static std::vector<std::string> StringList(const list_entry_t &list, UnifiedVectorFormat &list_data, const std::string &name)
+    {
+        std::vector<std::string> strings;
+        auto values = (string_t *)list_data.data;
+
+        for (idx_t i = 0; i < list.length; i++)
+        {
+            auto value_index = list_data.sel->get_index(list.offset + i);
+            if (!list_data.validity.RowIsValid(value_index))
+            {
+                throw InvalidInputException(name + " lists can't contain NULL.");
+            }
+            strings.push_back(values[value_index].GetString());
+        }
+
+        return strings;
+    }
+
+    static void BarcodeMatchFunction(DataChunk &args, ExpressionState &state, Vector &result)
+    {
+        auto &local_state = (BarcodeMatchLocalState &)*ExecuteFunctionState::GetFunctionState(state);
+        auto count = args.size();
+
+        UnifiedVectorFormat sequence_data, list_data, barcode_data, mismatch_data;
+        args.data[0].ToUnifiedFormat(count, sequence_data);
+        args.data[1].ToUnifiedFormat(count, list_data);
+        args.data[2].ToUnifiedFormat(count, mismatch_data);
+
+        auto &barcode_vector = ListVector::GetEntry(args.data[1]);
+        barcode_vector.ToUnifiedFormat(ListVector::GetListSize(args.data[1]), barcode_data);
+
+        auto sequences = (string_t *)sequence_data.data;
+        auto lists = (list_entry_t *)list_data.data;
+        auto barcodes = (string_t *)barcode_data.data;
+        auto mismatches = (int32_t *)mismatch_data.data;
+
+        auto results = FlatVector::GetData<string_t>(result);
+        result.SetVectorType(VectorType::FLAT_VECTOR);
+
+        // The list is usually a constant, so the index is checked once per chunk rather than once per read.
+        auto last_list = DConstants::INVALID_INDEX;
+        auto last_mismatches = DConstants::INVALID_INDEX;
+
+        for (idx_t i = 0; i < count; i++)
+        {
+            auto sequence_index = sequence_data.sel->get_index(i);
+            auto list_index = list_data.sel->get_index(i);
+            auto mismatch_index = mismatch_data.sel->get_index(i);
+
+            if (!sequence_data.validity.RowIsValid(sequence_index) || !list_data.validity.RowIsValid(list_index) || !mismatch_data.validity.RowIsValid(mismatch_index))
+            {
+                FlatVector::SetNull(result, i, true);
+                continue;
+            }
+
+            if (mismatches[mismatch_index] < 0)
+            {
+                throw InvalidInputException("max_mismatches must not be negative.");
+            }
+
+            idx_t max_mismatches = mismatches[mismatch_index];
+            auto &list = lists[list_index];
+
+            if (list_index != last_list || max_mismatches != last_mismatches)
+            {
+                auto &index = local_state.index;
+                if (!index || index->MaxMismatches() != max_mismatches || !StringListEquals(index->Barcodes(), list, barcode_data))
+                {
+                    index = make_uniq<BarcodeIndex>(StringList(list, barcode_data, "Barcode"), max_mismatches);
+                }
+
+                last_list = list_index;
+                last_mismatches = max_mismatches;
+            }
+
+            auto &sequence = sequences[sequence_index];
+            auto match = local_state.index->Match(sequence.GetDataUnsafe(), sequence.GetSize());
+            if (match == BarcodeIndex::NO_MATCH)
+            {
+                FlatVector::SetNull(result, i, true);
+                continue;
+            }
+
+            results[i] = StringVector::AddString(result, local_state.index->Barcodes()[match]);
+        }
+
+        if (args.AllConstant())
+        {
+            result.SetVectorType(VectorType::CONSTANT_VECTOR);
+        }
+    }
+
+    unique_ptr<CreateScalarFunctionInfo> ScalarFunctions::GetBarcodeMatchFunction()
+    {
+        auto function = ScalarFunction("barcode_match", {LogicalType::VARCHAR, LogicalType::LIST(LogicalType::VARCHAR), LogicalType::INTEGER}, LogicalType::VARCHAR, BarcodeMatchFunction);
+        function.init_local_state = BarcodeMatchInitLocalState;
+
+        CreateScalarFunctionInfo barcode_match_info(function);
+        return make_uniq<CreateScalarFunctionInfo>(barcode_match_info);
+    }
+
+    struct SeqFindAnyLocalState : public FunctionLocalState
+    {
+        unique_ptr<MotifMatcher> matcher;
+    };
+
+    static unique_ptr<FunctionLocalState> SeqFindAnyInitLocalState(ExpressionState &state, const BoundFunctionExpression &expr, FunctionData *bind_data)
+    {
+        return make_uniq<SeqFindAnyLocalState>();
+    }
+
+    static void SeqFindAnyFunction(DataChunk &args, ExpressionState &state, Vector &result)
+    {
+        auto &local_state = (SeqFindAnyLocalState &)*ExecuteFunctionState::GetFunctionState(state);
+        auto count = args.size();
+
+        UnifiedVectorFormat sequence_data, list_data, pattern_data, reverse_data;
+        args.data[0].ToUnifiedFormat(count, sequence_data);
+        args.data[1].ToUnifiedFormat(count, list_data);
+
+        auto &pattern_vector = ListVector::GetEntry(args.data[1]);
+        pattern_vector.ToUnifiedFormat(ListVector::GetListSize(args.data[1]), pattern_data);
+
+        auto has_reverse = args.ColumnCount() > 2;
+        if (has_reverse)
+        {
+            args.data[2].ToUnifiedFormat(count, reverse_data);
+        }
+
+        auto sequences = (string_t *)sequence_data.data;
+        auto lists = (list_entry_t *)list_data.data;
+        auto reverses = has_reverse ? (bool *)reverse_data.data : nullptr;
+
+        auto results = FlatVector::GetData<bool>(result);
+        result.SetVectorType(VectorType::FLAT_VECTOR);
+
+        auto last_list = DConstants::INVALID_INDEX;
+        auto last_reverse = false;
+
+        for (idx_t i = 0; i < count; i++)
+        {
+            auto sequence_index = sequence_data.sel->get_index(i);
+            auto list_index = list_data.sel->get_index(i);
+            auto reverse_index = has_reverse ? reverse_data.sel->get_index(i) : 0;
+
+            if (!sequence_data.validity.RowIsValid(sequence_index) || !list_data.validity.RowIsValid(list_index) ||
+                (has_reverse && !reverse_data.validity.RowIsValid(reverse_index)))
+            {
+                FlatVector::SetNull(result, i, true);
+                continue;
+            }
+
+            auto reverse_complement = has_reverse && reverses[reverse_index];
+            auto &list = lists[list_index];
+
+            if (list_index != last_list || reverse_complement != last_reverse)
+            {
+                auto &matcher = local_state.matcher;
+                if (!matcher || matcher->ReverseComplement() != reverse_complement || !StringListEquals(matcher->Patterns(), list, pattern_data))
+                {
+                    matcher = make_uniq<MotifMatcher>(StringList(list, pattern_data, "Pattern"), reverse_complement);
+                }
+
+                last_list = list_index;
+                last_reverse = reverse_complement;
+            }
+
+            auto &sequence = sequences[sequence_index];
+            results[i] = local_state.matcher->Matches(sequence.GetDataUnsafe(), sequence.GetSize());
+        }
+
+        if (args.AllConstant())
+        {
+            result.SetVectorType(VectorType::CONSTANT_VECTOR);
+        }
+    }
+
+    unique_ptr<CreateScalarFunctionInfo> ScalarFunctions::GetSeqFindAnyFunction()
+    {
+        ScalarFunctionSet set("seq_find_any");
+
+        auto patterns = ScalarFunction({LogicalType::VARCHAR, LogicalType::LIST(LogicalType::VARCHAR)}, LogicalType::BOOLEAN, SeqFindAnyFunction);
+        patterns.init_local_state = SeqFindAnyInitLocalState;
+        set.AddFunction(patterns);
+
+        auto reverse_complement = ScalarFunction({LogicalType::VARCHAR, LogicalType::LIST(LogicalType::VARCHAR), LogicalType::BOOLEAN}, LogicalType::BOOLEAN, SeqFindAnyFunction);
+        reverse_complement.init_local_state = SeqFindAnyInitLocalState;
+        set.AddFunction(reverse_complement);
+
+        return make_uniq<CreateScalarFunctionInfo>(set);
+    }
+
+    struct KmerBloomHitsLocalState : public FunctionLocalState
+    {
+        // The blob the filter was read from, a new filter is only deserialized when it changes.
+        std::string blob;
+        unique_ptr<KmerBloomFilter> filter;
+    };
+
+    static unique_ptr<FunctionLocalState> KmerBloomHitsInitLocalState(ExpressionState &state, const BoundFunctionExpression &expr, FunctionData *bind_data)
+    {
+        return make_uniq<KmerBloomHitsLocalState>();
+    }
+
+    static void KmerBloomHitsFunction(DataChunk &args, ExpressionState &state, Vector &result)
+    {
+        auto &local_state = (KmerBloomHitsLocalState &)*ExecuteFunctionState::GetFunctionState(state);
+        auto count = args.size();
+
+        UnifiedVectorFormat sequence_data, filter_data, k_data;
+        args.data[0].ToUnifiedFormat(count, sequence_data);
+        args.data[1].ToUnifiedFormat(count, filter_data);
+        args.data[2].ToUnifiedFormat(count, k_data);
+
+        auto sequences = (string_t *)sequence_data.data;
+        auto filters = (string_t *)filter_data.data;
+        auto ks = (int32_t *)k_data.data;
+
+        auto results = FlatVector::GetData<int64_t>(result);
+        result.SetVectorType(VectorType::FLAT_VECTOR);
+
+        // The filter is usually a constant, so it's compared once per chunk rather than once per read.
+        auto last_filter = DConstants::INVALID_INDEX;
+
+        for (idx_t i = 0; i < count; i++)
+        {
+            auto sequence_index = sequence_data.sel->get_index(i);
+            auto filter_index = filter_data.sel->get_index(i);
+            auto k_index = k_data.sel->get_index(i);
+
+            if (!sequence_data.validity.RowIsValid(sequence_index) || !filter_data.validity.RowIsValid(filter_index) || !k_data.validity.RowIsValid(k_index))
+            {
+                FlatVector::SetNull(result, i, true);
+                continue;
+            }
+
+            if (filter_index != last_filter)
+            {
+                auto &blob = filters[filter_index];
+                if (!local_state.filter || blob.GetSize() != local_state.blob.size() || memcmp(blob.GetDataUnsafe(), local_state.blob.data(), blob.GetSize()) != 0)
+                {
+                    local_state.filter = make_uniq<KmerBloomFilter>(KmerBloomFilter::Deserialize(blob.GetDataUnsafe(), blob.GetSize()));
+                    local_state.blob = blob.GetString();
+                }
+
+                last_filter = filter_index;
+            }
+
+            if (ks[k_index] < 0 || (idx_t)ks[k_index] != local_state.filter->K())
+            {
+                throw InvalidInputException("k is " + std::to_string(ks[k_index]) + " but the filter was built with k " + std::to_string(local_state.filter->K()) + ".");
+            }
+
+            auto &sequence = sequences[sequence_index];
+            results[i] = local_state.filter->Hits(sequence.GetDataUnsafe(), sequence.GetSize());
+        }
+
+        if (args.AllConstant())
+        {
+            result.SetVectorType(VectorType::CONSTANT_VECTOR);
+        }
+    }
+
+    unique_ptr<CreateScalarFunctionInfo> ScalarFunctions::GetKmerBloomHitsFunction()
+    {
+        auto function = ScalarFunction("kmer_bloom_hits", {LogicalType::VARCHAR, LogicalType::BLOB, LogicalType::INTEGER}, LogicalType::BIGINT, KmerBloomHitsFunction);
+        function.init_local_state = KmerBloomHitsInitLocalState;
+
+        CreateScalarFunctionInfo kmer_bloom_hits_info(function);
+        return make_uniq<CreateScalarFunctionInfo>(kmer_bloom_hits_info);
+    }
+
+    unique_ptr<CreateScalarFunctionInfo> ScalarFunctions::GetFastxFetchFunction()
+    {
+        child_list_t<LogicalType> children;
+        children.push_back(make_pair("id", LogicalType::VARCHAR));
+        children.push_back(make_pair("description", LogicalType::VARCHAR));
+        children.push_back(make_pair("sequence", LogicalType::VARCHAR));
+        children.push_back(make_pair("quality_scores", LogicalType::VARCHAR));
+
+        auto function = ScalarFunction("fastx_fetch", {LogicalType::VARCHAR, LogicalType::BIGINT}, LogicalType::STRUCT(std::move(children)), FastxFetchFunction);
+        function.init_local_state = FastxFetchInitLocalState;
+
+        CreateScalarFunctionInfo fastx_fetch_info(function);
+        return make_uniq<CreateScalarFunctionInfo>(fastx_fetch_info);
+    }
+
+}